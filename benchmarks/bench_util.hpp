@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+#include "../src/lib/points.hpp"
+#include "../src/lib/random.hpp"
+
+#include "benchmark/benchmark.h"
+
+/// Number of heap allocations made by the benchmark process so far (counted by the replaced `operator new`).
+extern std::atomic<size_t> allocation_count;
+
+constexpr ll BENCH_MAX_COORD = 1e17;
+
+/**
+ * @brief Generates points uniformly at random from [0, 10]^dim.
+ * @param n The number of points.
+ * @param dim The dimension of the space.
+ * @return The generated points.
+ */
+inline std::vector<tagged_point> random_points(int n, int dim) {
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (auto& p: points) {
+        for (int i=0; i<dim; i++) {
+            p[i] = randRange<ll>(0LL, BENCH_MAX_COORD);
+        }
+    }
+    return points;
+}
+
+/**
+ * @brief Counts allocations made during a benchmark and reports them together with throughput.
+ *
+ * Construct right before the benchmark loop and call `report` right after it.
+ */
+class bench_report {
+  private:
+    size_t _allocations_start;
+  public:
+    bench_report() : _allocations_start(allocation_count.load()) {}
+
+    /**
+     * @brief Reports throughput in points/s and average number of allocations per iteration.
+     * @param state The benchmark state.
+     * @param points How many points a single iteration processes.
+     */
+    void report(benchmark::State& state, size_t points) const {
+        state.SetItemsProcessed(state.iterations() * points);
+        state.counters["allocs"] = benchmark::Counter(
+            allocation_count.load() - _allocations_start,
+            benchmark::Counter::kAvgIterations
+        );
+    }
+};
@@ -0,0 +1,30 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "clustering_benchmarks.hpp"
+#include "hashing_benchmarks.hpp"
+#include "points_benchmarks.hpp"
+
+#include "benchmark/benchmark.h"
+
+std::atomic<size_t> allocation_count{0};
+
+// Replaced allocation functions are paired with each other, GCC cannot see that
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,51 @@
+#pragma once
+#include "../src/lib/clustering.hpp"
+#include "bench_util.hpp"
+
+#include "benchmark/benchmark.h"
+
+/**
+ * Slides a window of `window` points by `batch` points per iteration (insert, then expire),
+ * starting from a clustering of a full window, and reports the inserted points/s.
+ */
+static void BM_SlidingWindow(benchmark::State& state) {
+    int window = state.range(0), dim = state.range(1), batch = state.range(3);
+    HashingSchemeChoice hs_choice = (HashingSchemeChoice) state.range(2);
+    std::vector<std::vector<tagged_point>> batches;
+    for (int b=0; b<10; b++) {
+        batches.push_back(random_points(batch, dim));
+    }
+    IncrementalClustering<pow_z<1>> clustering(dim, random_points(window, dim), 10, hs_choice, pow_z<1>());
+
+    size_t b = 0;
+    bench_report report;
+    for (auto _: state) {
+        clustering.insert(batches[b++ % batches.size()]);
+        clustering.expire(batch);
+    }
+    report.report(state, batch);
+}
+
+static void BM_SlidingWindowCenters(benchmark::State& state) {
+    int window = state.range(0), dim = state.range(1);
+    HashingSchemeChoice hs_choice = (HashingSchemeChoice) state.range(2);
+    IncrementalClustering<pow_z<1>> clustering(dim, random_points(window, dim), 10, hs_choice, pow_z<1>());
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(clustering.centers());
+    }
+    report.report(state, window);
+}
+
+// Building the initial clustering dominates, so the iteration count is fixed
+BENCHMARK(BM_SlidingWindow)
+    ->ArgNames({"window", "dim", "scheme", "batch"})
+    ->ArgsProduct({{2000, 10000}, {2, 5}, {GridHashingScheme, FaceHashingScheme, LatticeHashingScheme}, {10, 100}})
+    ->Iterations(50)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SlidingWindowCenters)
+    ->ArgNames({"window", "dim", "scheme"})
+    ->ArgsProduct({{2000, 10000}, {2, 5}, {GridHashingScheme, FaceHashingScheme, LatticeHashingScheme}})
+    ->Iterations(50)
+    ->Unit(benchmark::kMillisecond);
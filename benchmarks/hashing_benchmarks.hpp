@@ -0,0 +1,163 @@
+#pragma once
+#include "../src/lib/hashing.hpp"
+#include "../src/lib/eval_composable.hpp"
+#include "bench_util.hpp"
+
+#include "benchmark/benchmark.h"
+
+/// Radius of the typical nearest neighbor distance for `random_points(n, dim)`.
+inline double typical_radius(int n, int dim) {
+    return 10.0 / pow(n, 1.0 / dim);
+}
+
+static void BM_Hash(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    HashingSchemeChoice hs_choice = (HashingSchemeChoice) state.range(2);
+    auto points = random_points(n, dim);
+    auto hashing_scheme = make_hashing_scheme<int>(hs_choice, dim, typical_radius(n, dim));
+
+    bench_report report;
+    for (auto _: state) {
+        for (const auto& p: points) {
+            benchmark::DoNotOptimize(hashing_scheme->hash(p));
+        }
+    }
+    report.report(state, n);
+}
+
+static void BM_EvalBall(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    HashingSchemeChoice hs_choice = (HashingSchemeChoice) state.range(2);
+    auto points = random_points(n, dim);
+    double radius = typical_radius(n, dim);
+    auto hashing_scheme = make_hashing_scheme<int>(hs_choice, dim, radius);
+
+    BucketTable<int> bucket_values(n);
+    for (const auto& p: points) {
+        bucket_values.get_or_insert(hashing_scheme->hash(p), NULL, 0)++;
+    }
+
+    bench_report report;
+    for (auto _: state) {
+        for (const auto& p: points) {
+            benchmark::DoNotOptimize(hashing_scheme->eval_ball(p, radius, Composable::Size, bucket_values));
+        }
+    }
+    report.report(state, n);
+}
+
+static void BM_EvalComposable(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    HashingSchemeChoice hs_choice = (HashingSchemeChoice) state.range(2);
+    auto points = random_points(n, dim);
+    double radius = typical_radius(n, dim);
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(eval_composable(dim, points, radius, Composable::Size, hs_choice));
+    }
+    report.report(state, n);
+}
+
+static void BM_EvalComposableExact(benchmark::State& state) {
+    bucket_identity = CellBucketIdentity;
+    BM_EvalComposable(state);
+    bucket_identity = HashBucketIdentity;
+}
+
+#define HASHING_ARGS \
+    ArgNames({"n", "dim", "scheme"}) \
+    ->ArgsProduct({{1000, 10000, 100000}, {2, 5, 10}, {GridHashingScheme, FaceHashingScheme, LSHHashingScheme, LatticeHashingScheme}}) \
+    ->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_Hash)->HASHING_ARGS;
+BENCHMARK(BM_EvalBall)->HASHING_ARGS;
+BENCHMARK(BM_EvalComposable)->HASHING_ARGS;
+BENCHMARK(BM_EvalComposableExact)->HASHING_ARGS;
+
+/// Keys with the structure of the bucket hashes (31-bit), half of the lookups miss.
+inline std::pair<std::vector<ull>, std::vector<ull>> bucket_keys(int buckets) {
+    std::vector<ull> keys(buckets), queries(buckets);
+    for (int i=0; i<buckets; i++) {
+        keys[i] = randRange<ull>(0, 2147483646);
+        queries[i] = i % 2 ? keys[randRange(0, i)] : randRange<ull>(0, 2147483646);
+    }
+    return {keys, queries};
+}
+
+static void BM_BucketLookupUnorderedMap(benchmark::State& state) {
+    auto [keys, queries] = bucket_keys(state.range(0));
+    std::unordered_map<ull, int> bucket_values;
+    for (ull key: keys) bucket_values[key]++;
+
+    bench_report report;
+    for (auto _: state) {
+        for (ull query: queries) {
+            auto it = bucket_values.find(query);
+            benchmark::DoNotOptimize(it != bucket_values.end() ? it->second : 0);
+        }
+    }
+    report.report(state, queries.size());
+}
+
+static void BM_BucketLookupFlatHashMap(benchmark::State& state) {
+    auto [keys, queries] = bucket_keys(state.range(0));
+    FlatHashMap<int> bucket_values(keys.size());
+    for (ull key: keys) bucket_values.get_or_insert(key, 0)++;
+
+    bench_report report;
+    for (auto _: state) {
+        for (ull query: queries) {
+            const int* value = bucket_values.find(query);
+            benchmark::DoNotOptimize(value != NULL ? *value : 0);
+        }
+    }
+    report.report(state, queries.size());
+}
+
+static void BM_BucketLookupFlatHashMapBatch(benchmark::State& state) {
+    constexpr size_t batch = 16;
+    auto [keys, queries] = bucket_keys(state.range(0));
+    FlatHashMap<int> bucket_values(keys.size());
+    for (ull key: keys) bucket_values.get_or_insert(key, 0)++;
+
+    bench_report report;
+    const int* values[batch];
+    for (auto _: state) {
+        for (size_t i=0; i+batch<=queries.size(); i+=batch) {
+            bucket_values.find_batch(&queries[i], batch, values);
+            benchmark::DoNotOptimize(values);
+        }
+    }
+    report.report(state, queries.size() / batch * batch);
+}
+
+static void BM_BucketAggregateUnorderedMap(benchmark::State& state) {
+    auto [keys, _queries] = bucket_keys(state.range(0));
+    bench_report report;
+    for (auto _: state) {
+        std::unordered_map<ull, int> bucket_values;
+        for (ull key: keys) bucket_values[key]++;
+        benchmark::DoNotOptimize(bucket_values);
+    }
+    report.report(state, keys.size());
+}
+
+static void BM_BucketAggregateFlatHashMap(benchmark::State& state) {
+    auto [keys, _queries] = bucket_keys(state.range(0));
+    bench_report report;
+    for (auto _: state) {
+        FlatHashMap<int> bucket_values(keys.size());
+        for (ull key: keys) bucket_values.get_or_insert(key, 0)++;
+        benchmark::DoNotOptimize(bucket_values);
+    }
+    report.report(state, keys.size());
+}
+
+#define BUCKET_ARGS ArgNames({"buckets"})->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_BucketLookupUnorderedMap)->BUCKET_ARGS;
+BENCHMARK(BM_BucketLookupFlatHashMap)->BUCKET_ARGS;
+BENCHMARK(BM_BucketLookupFlatHashMapBatch)->BUCKET_ARGS;
+BENCHMARK(BM_BucketAggregateUnorderedMap)->BUCKET_ARGS;
+BENCHMARK(BM_BucketAggregateFlatHashMap)->BUCKET_ARGS;
@@ -0,0 +1,134 @@
+#pragma once
+#include <sstream>
+
+#include "../src/lib/points.hpp"
+#include "../src/lib/compact_points.hpp"
+#include "bench_util.hpp"
+
+#include "benchmark/benchmark.h"
+
+static void BM_MinDist(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1), k = state.range(2);
+    auto points = random_points(n, dim);
+    auto facilities = random_points(k, dim);
+
+    bench_report report;
+    for (auto _: state) {
+        for (const auto& p: points) {
+            benchmark::DoNotOptimize(min_dist(p, facilities));
+        }
+    }
+    report.report(state, n);
+}
+
+static void BM_SolutionCost(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1), k = state.range(2), z = state.range(3);
+    auto points = random_points(n, dim);
+    auto facilities_tagged = random_points(k, dim);
+    std::vector<point> facilities(facilities_tagged.begin(), facilities_tagged.end());
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(dispatch_z(z, [&](auto pz) { return solution_cost(points, facilities, 1.0, pz); }));
+    }
+    report.report(state, n);
+}
+
+static void BM_SolutionCostCompact(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1), k = state.range(2);
+    CoordinateStorage storage = (CoordinateStorage) state.range(3);
+    CompactPoints points(dim, random_points(n, dim), storage);
+    auto facilities_tagged = random_points(k, dim);
+    std::vector<point> facilities(facilities_tagged.begin(), facilities_tagged.end());
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(solution_cost(points, facilities, 1.0, pow_z<1>{}));
+    }
+    report.report(state, n);
+    state.SetBytesProcessed(state.iterations() * points.bytes());
+}
+
+static void BM_NearestNeighbors(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1), projections = state.range(2);
+    auto points = random_points(n, dim);
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(nearest_neighbors(dim, points, projections));
+    }
+    report.report(state, n);
+}
+
+static void BM_AspectRatio(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    auto points = random_points(n, dim);
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(aspect_ratio(dim, points));
+    }
+    report.report(state, n);
+}
+
+static void BM_ClosestPair(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    auto points = random_points(n, dim);
+
+    bench_report report;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(closest_pair(dim, points));
+    }
+    report.report(state, n);
+}
+
+static void BM_LoadPoints(benchmark::State& state) {
+    int n = state.range(0), dim = state.range(1);
+    std::ostringstream input;
+    input.precision(10);
+    for (const auto& p: random_points(n, dim)) {
+        for (int i=0; i<dim; i++) {
+            input << (double) p[i] / scale << (i+1 < dim ? " " : "\n");
+        }
+    }
+    std::string text = input.str();
+
+    std::streambuf* original_cin = std::cin.rdbuf();
+    bench_report report;
+    for (auto _: state) {
+        std::istringstream stream(text);
+        std::cin.rdbuf(stream.rdbuf());
+        benchmark::DoNotOptimize(load_points(n, dim));
+    }
+    std::cin.rdbuf(original_cin);
+    report.report(state, n);
+}
+
+BENCHMARK(BM_MinDist)
+    ->ArgNames({"n", "dim", "k"})
+    ->ArgsProduct({{10000, 100000}, {2, 5, 10}, {10, 100}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SolutionCost)
+    ->ArgNames({"n", "dim", "k", "z"})
+    ->ArgsProduct({{10000, 100000}, {2, 5, 10}, {10, 100}, {1, 2, 3}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SolutionCostCompact)
+    ->ArgNames({"n", "dim", "k", "storage"})
+    ->ArgsProduct({{1000000}, {50}, {1, 10}, {Int64Storage, Float32Storage, Int32Storage, Int16Storage}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_NearestNeighbors)
+    ->ArgNames({"n", "dim", "projections"})
+    ->ArgsProduct({{1000, 10000, 100000, 1000000}, {2, 10}, {4, 16}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AspectRatio)
+    ->ArgNames({"n", "dim"})
+    ->ArgsProduct({{1000, 10000, 30000}, {2, 10}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ClosestPair)
+    ->ArgNames({"n", "dim"})
+    ->ArgsProduct({{10000, 100000, 1000000}, {2, 4}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadPoints)
+    ->ArgNames({"n", "dim"})
+    ->ArgsProduct({{10000, 100000}, {2, 5, 10}})
+    ->Unit(benchmark::kMillisecond);
@@ -15,7 +15,8 @@ SOLUTION_COLORS = {
     "K-medoids PAM (scikit-learn-extra)": "orange",
     "K-means++ (scikit-learn)": "red",
     "Grid hashing": "blue",
-    "Face hashing": "green"
+    "Face hashing": "green",
+    "Lattice hashing": "purple"
 }
 SOLUTION_MARKER = {
     "Mettu-Plaxton": "o",
@@ -23,7 +24,8 @@ SOLUTION_MARKER = {
     "K-medoids PAM (scikit-learn-extra)": "d",
     "K-means++ (scikit-learn)": "o",
     "Grid hashing": "^",
-    "Face hashing": "v"
+    "Face hashing": "v",
+    "Lattice hashing": "s"
 }
 PLOT_DIMENSIONS = [2, 5, 10]
 PLOT_SIZES = [10000]
@@ -35,6 +37,8 @@ def get_color(args: list[str]):
         return "b"
     elif args[0] == "face_hashing":
         return "g"
+    elif args[0] == "lattice_hashing":
+        return "m"
 
 def plot_instance(title: str, values):
     solutions = defaultdict(list)
@@ -82,6 +86,8 @@ def plot_file(filename: str):
 
         for line in reader:
             inp, solution, args, *params = line
+            # Rows from the in-process driver carry thread count and per-phase times after the time
+            params = params[:len(FL_VALUES if "fl" in filename else CL_VALUES)]
             args = args.split()
 
             if len(args) == 2:
@@ -89,6 +95,8 @@ def plot_file(filename: str):
                     solution = "Grid hashing"
                 elif args[0] == "face_hashing":
                     solution = "Face hashing"
+                elif args[0] == "lattice_hashing":
+                    solution = "Lattice hashing"
                 else:
                     raise ValueError(f"Unrecognized argument: {args[0]}")
             elif solution.startswith("mettu_plaxton"):
@@ -4,12 +4,17 @@
 #include "lib/util.hpp"
 #include "lib/hashing.hpp"
 #include "lib/points.hpp"
+#include "lib/dimension_reduction.hpp"
 #include "lib/clustering.hpp"
 
 using namespace std;
 
 
 int main(int argc, char const *argv[]) {
+    double z = parse_z(argc, argv);
+    double jl_epsilon = parse_jl(argc, argv);
+    int jl_dim = parse_jl_dim(argc, argv);
+    parse_hashing_options(argc, argv);
     if (argc != 3) invalid_usage_solver();
     HashingSchemeChoice hs_choice = choose_hashing_scheme(argv[1]);
     seed(strtoull(argv[2], 0, 16));
@@ -18,7 +23,10 @@ int main(int argc, char const *argv[]) {
     std::cin >> n >> dim >> k;
     auto points = load_points(n, dim);
 
-    auto chosen = compute_clusters_seq(dim, points, k, hs_choice);
+    int solve_dim = dim;
+    auto solve_points = reduce_dimension(solve_dim, points, jl_epsilon, jl_dim);
+    report_skipped_reduction(points.size(), dim, jl_epsilon, jl_dim);
+    auto chosen = dispatch_z(z, [&](auto pz) { return compute_clusters_seq(solve_dim, solve_points, k, hs_choice, pz); });
     std::cout << std::setprecision(15);
     for (auto c: chosen) {
         std::cout << points[c];
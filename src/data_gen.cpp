@@ -64,7 +64,7 @@ std::vector<point> gen_clusters(int n, int dim) {
         all_points[all_points_sz++] = centers[cluster] + rand_shift(dim); 
     }
 
-    shuffle(all_points.begin(), all_points.end(), rng);
+    shuffle(all_points.begin(), all_points.end(), rng());
     return all_points;
 }
 
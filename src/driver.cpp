@@ -0,0 +1,258 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "lib/hashing.hpp"
+#include "lib/points.hpp"
+#include "lib/dimension_reduction.hpp"
+#include "lib/duplicates.hpp"
+#include "lib/pow_z.hpp"
+#include "lib/util.hpp"
+#include "lib/r_p.hpp"
+#include "lib/timing.hpp"
+#include "lib/instrumentation.hpp"
+#include "lib/clustering.hpp"
+#include "lib/facility_set.hpp"
+
+[[noreturn]]
+void invalid_usage_driver() {
+    std::cerr << "Usage: ./driver {fl,cl} <input> {mettu_plaxton, facility_set, clustering} [{face_hashing, grid_hashing, lsh_hashing, lattice_hashing} seed]"
+              << " [--warmup W] [--repeat R] [--threads T1,T2,...] [--output FILE] [--stats FILE] [--z Z] [--jl EPS] [--jl-dim D] [--exact-buckets] [--lsh-tables L] [--lsh-projections M] [--bucket-cache MB] [--stream CHUNK] [--merge-reduce CHUNK] [--dedup] [--incremental BATCH]" << std::endl;
+    exit(2);
+}
+
+struct run_result {
+    std::vector<int> chosen;
+    double time;
+    double phases[PHASE_COUNT];
+};
+
+template<IsPoint T, IsPowZ P>
+std::vector<int> solve(const std::string& solution, int dim, const std::vector<T>& points, double k_or_cost, HashingSchemeChoice hs_choice, double jl_epsilon, int jl_dim, size_t merge_reduce_chunk, P pz) {
+    // Indexes into the projection are indexes into points, the cost is evaluated on the original coordinates
+    std::vector<T> solve_points = reduce_dimension(dim, points, jl_epsilon, jl_dim);
+    if (solution == "facility_set") {
+        return compute_facilities(dim, solve_points, k_or_cost, hs_choice, pz);
+    } else if (merge_reduce_chunk > 0) {
+        std::vector<weighted_point> weighted_points;
+        weighted_points.reserve(solve_points.size());
+        for (const T& p: solve_points) {
+            weighted_points.push_back(p);
+            weighted_points.back().weight = weight_of(p);
+        }
+        return compute_clusters_merge_reduce(dim, weighted_points, (int) k_or_cost, hs_choice, pz, merge_reduce_chunk);
+    } else {
+        return compute_clusters_seq(dim, solve_points, (int) k_or_cost, hs_choice, pz);
+    }
+}
+
+template<IsPowZ P>
+run_result run(const std::string& solution, const std::string& input, int dim, const std::vector<tagged_point>& points, const unique_points* unique, double k_or_cost, HashingSchemeChoice hs_choice, ull seed_value, double jl_epsilon, int jl_dim, size_t stream_chunk, size_t merge_reduce_chunk, size_t incremental_batch, P pz) {
+    seed(seed_value);
+    reset_phase_times();
+    auto start = std::chrono::steady_clock::now();
+
+    run_result result;
+    if (stream_chunk > 0) {
+        // Reads the input in chunks, the points are never loaded at once
+        std::ifstream in(input);
+        int n, stream_dim; double facility_cost;
+        in >> n >> stream_dim >> facility_cost;
+        ChunkedPointReader reader(in, n, stream_dim, stream_chunk);
+        result.chosen = compute_facilities_streaming(reader, facility_cost, hs_choice, pz);
+    } else if (solution == "mettu_plaxton") {
+        std::vector<tagged_point> rp_points(points);
+        calc_rps(rp_points, k_or_cost, pz);
+        result.chosen = mettu_plaxton(rp_points);
+    } else if (incremental_batch > 0) {
+        // Clusters the first batch, then inserts the other batches one by one
+        int solve_dim = dim;
+        std::vector<tagged_point> solve_points = reduce_dimension(solve_dim, points, jl_epsilon, jl_dim);
+        auto batch = [&](size_t begin) {
+            return std::vector<tagged_point>(solve_points.begin() + begin, solve_points.begin() + std::min(solve_points.size(), begin + incremental_batch));
+        };
+        IncrementalClustering<P> clustering(solve_dim, batch(0), (int) k_or_cost, hs_choice, pz);
+        for (size_t begin=incremental_batch; begin<solve_points.size(); begin+=incremental_batch) {
+            clustering.insert(batch(begin));
+        }
+        result.chosen = clustering.centers();
+    } else if (unique != NULL) {
+        // Solved on the distinct points weighted by their copies, each chosen point maps to its first copy
+        result.chosen = unique->to_original(solve(solution, dim, unique->points, k_or_cost, hs_choice, jl_epsilon, jl_dim, merge_reduce_chunk, pz));
+    } else {
+        result.chosen = solve(solution, dim, points, k_or_cost, hs_choice, jl_epsilon, jl_dim, merge_reduce_chunk, pz);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.time = elapsed.count();
+    for (int i=0; i<PHASE_COUNT; i++) {
+        result.phases[i] = phase_times[i];
+    }
+    return result;
+}
+
+int main(int argc, char const *argv[]) {
+    double z = parse_z(argc, argv);
+    double jl_epsilon = parse_jl(argc, argv);
+    int jl_dim = parse_jl_dim(argc, argv);
+    std::string hashing_options = parse_hashing_options(argc, argv);
+    std::vector<std::string> args(argv + 1, argv + argc);
+    int warmup = 1, repeat = 3;
+    std::vector<int> thread_counts = {omp_get_max_threads()};
+    std::string output = "", stats = "";
+    size_t stream_chunk = 0, merge_reduce_chunk = 0, incremental_batch = 0;
+    bool dedup = false;
+    std::vector<std::string> positional;
+    for (size_t i=0; i<args.size(); i++) {
+        if (i+1 < args.size() && args[i] == "--warmup") {
+            warmup = std::stoi(args[++i]);
+        } else if (i+1 < args.size() && args[i] == "--repeat") {
+            repeat = std::stoi(args[++i]);
+        } else if (i+1 < args.size() && args[i] == "--threads") {
+            thread_counts.clear();
+            std::stringstream counts(args[++i]);
+            std::string count;
+            while (std::getline(counts, count, ',')) {
+                thread_counts.push_back(std::stoi(count));
+            }
+        } else if (i+1 < args.size() && args[i] == "--output") {
+            output = args[++i];
+        } else if (i+1 < args.size() && args[i] == "--stats") {
+            stats = args[++i];
+        } else if (i+1 < args.size() && args[i] == "--stream") {
+            stream_chunk = std::stoull(args[++i]);
+        } else if (i+1 < args.size() && args[i] == "--merge-reduce") {
+            merge_reduce_chunk = std::stoull(args[++i]);
+        } else if (i+1 < args.size() && args[i] == "--incremental") {
+            incremental_batch = std::stoull(args[++i]);
+        } else if (args[i] == "--dedup") {
+            dedup = true;
+        } else {
+            positional.push_back(args[i]);
+        }
+    }
+
+    if (positional.size() < 3 || repeat < 1 || warmup < 0) invalid_usage_driver();
+    std::string target = positional[0], input = positional[1], solution = positional[2];
+    if (target != "fl" && target != "cl") invalid_usage_driver();
+    if (target == "fl" && solution != "mettu_plaxton" && solution != "facility_set") invalid_usage_driver();
+    if (target == "cl" && solution != "clustering") invalid_usage_driver();
+    if (stream_chunk > 0 && (solution != "facility_set" || jl_epsilon > 0 || jl_dim > 0)) invalid_usage_driver();
+    if (merge_reduce_chunk > 0 && solution != "clustering") invalid_usage_driver();
+    if (dedup && (solution == "mettu_plaxton" || stream_chunk > 0)) invalid_usage_driver();
+    if (incremental_batch > 0 && (solution != "clustering" || merge_reduce_chunk > 0 || dedup)) invalid_usage_driver();
+
+    HashingSchemeChoice hs_choice = GridHashingScheme;
+    ull seed_value = 0;
+    std::string solution_args = "";
+    if (solution == "mettu_plaxton") {
+        if (positional.size() != 3) invalid_usage_driver();
+    } else {
+        if (positional.size() != 5) invalid_usage_driver();
+        hs_choice = choose_hashing_scheme(positional[3]);
+        seed_value = strtoull(positional[4].c_str(), 0, 16);
+        solution_args = positional[3] + " " + positional[4] + hashing_options;
+        if (jl_epsilon > 0) {
+            std::ostringstream epsilon;
+            epsilon << jl_epsilon;
+            solution_args += " --jl " + epsilon.str();
+        }
+        if (jl_dim > 0) {
+            solution_args += " --jl-dim " + std::to_string(jl_dim);
+        }
+        if (stream_chunk > 0) {
+            solution_args += " --stream " + std::to_string(stream_chunk);
+        }
+        if (merge_reduce_chunk > 0) {
+            solution_args += " --merge-reduce " + std::to_string(merge_reduce_chunk);
+        }
+        if (dedup) {
+            solution_args += " --dedup";
+        }
+        if (incremental_batch > 0) {
+            solution_args += " --incremental " + std::to_string(incremental_batch);
+        }
+    }
+
+    std::ifstream in(input);
+    if (!in) invalid_usage_driver();
+    int n, dim; double k_or_cost;
+    in >> n >> dim >> k_or_cost;
+    reset_phase_times();
+    // Every pass over the points when streaming starts where the header ends
+    ChunkedPointReader reader(in, n, dim, stream_chunk);
+    std::vector<tagged_point> points;
+    if (stream_chunk == 0) points = load_points(n, dim, in);
+    std::unique_ptr<unique_points> unique = dedup ? std::make_unique<unique_points>(collapse_duplicates(dim, points)) : NULL;
+    double load_time = phase_times[LoadPhase];
+    if (solution != "mettu_plaxton") {
+        report_skipped_reduction(unique ? unique->points.size() : points.size(), dim, jl_epsilon, jl_dim);
+    }
+
+    std::cout << std::setprecision(15);
+    for (int threads: thread_counts) {
+        omp_set_num_threads(threads);
+        for (int i=0; i<warmup; i++) {
+            dispatch_z(z, [&](auto pz) { return run(solution, input, dim, points, unique.get(), k_or_cost, hs_choice, seed_value, jl_epsilon, jl_dim, stream_chunk, merge_reduce_chunk, incremental_batch, pz); });
+        }
+
+        double total_time = 0;
+        double total_phases[PHASE_COUNT] = {0};
+        run_result result;
+        for (int i=0; i<repeat; i++) {
+            instrumentation::reset();
+            result = dispatch_z(z, [&](auto pz) { return run(solution, input, dim, points, unique.get(), k_or_cost, hs_choice, seed_value, jl_epsilon, jl_dim, stream_chunk, merge_reduce_chunk, incremental_batch, pz); });
+            total_time += result.time;
+            for (int p=0; p<PHASE_COUNT; p++) {
+                total_phases[p] += result.phases[p];
+            }
+        }
+
+        if (stats != "") {
+            std::ofstream out(stats);
+            instrumentation::dump(out);
+        }
+
+        // When streaming, the chosen points are read and the cost is evaluated in passes over the input
+        double facility_cost = target == "fl" ? k_or_cost : 0.0;
+        std::vector<point> chosen_points;
+        double cost;
+        if (stream_chunk > 0) {
+            for (tagged_point& p: read_points(reader, result.chosen)) {
+                chosen_points.push_back(std::move(p));
+            }
+            cost = dispatch_z(z, [&](auto pz) { return solution_cost(reader, chosen_points, facility_cost, pz); });
+        } else {
+            for (int c: result.chosen) {
+                chosen_points.push_back(points[c]);
+            }
+            cost = dispatch_z(z, [&](auto pz) { return solution_cost(points, chosen_points, facility_cost, pz); });
+        }
+
+        if (output != "") {
+            std::ofstream out(output);
+            out << std::setprecision(15);
+            for (const point& p: chosen_points) {
+                for (int i=0; i<dim; i++) {
+                    out << (double) p[i] / scale << (i+1 < dim ? " " : "\n");
+                }
+            }
+        }
+
+        // Same columns as results_*.csv of test.py followed by the thread count and per-phase times
+        std::string input_name = input.substr(input.find_last_of('/') + 1);
+        std::cout << input_name << "," << solution << "_z" << z << "," << solution_args << ",";
+        if (target == "cl") std::cout << result.chosen.size() << ",";
+        std::cout << std::fixed << std::setprecision(4) << cost << std::defaultfloat << std::setprecision(15)
+                  << "," << total_time / repeat << "," << threads << "," << load_time;
+        for (int p=LoadPhase+1; p<PHASE_COUNT; p++) {
+            std::cout << "," << total_phases[p] / repeat;
+        }
+        std::cout << std::endl;
+    }
+}
@@ -3,18 +3,41 @@
 #include "lib/util.hpp"
 #include "lib/hashing.hpp"
 #include "lib/points.hpp"
+#include "lib/dimension_reduction.hpp"
 #include "lib/facility_set.hpp"
 
 int main(int argc, char const *argv[]) {
-    if (argc != 3) invalid_usage_solver();
+    double z = parse_z(argc, argv);
+    double jl_epsilon = parse_jl(argc, argv);
+    int jl_dim = parse_jl_dim(argc, argv);
+    size_t stream_chunk = parse_stream(argc, argv);
+    parse_hashing_options(argc, argv);
+    if (argc != 3 || (stream_chunk > 0 && (jl_epsilon > 0 || jl_dim > 0))) invalid_usage_solver();
     HashingSchemeChoice hs_choice = choose_hashing_scheme(argv[1]);
     seed(strtoull(argv[2], 0, 16));
 
     int n, dim; double facility_cost;
     std::cin >> n >> dim >> facility_cost;
+    if (stream_chunk > 0) {
+        // The points are read in chunks in each pass, so the input has to be seekable (a file, not a pipe)
+        if (std::cin.tellg() == -1) {
+            std::cerr << "--stream needs the input redirected from a file" << std::endl;
+            exit(2);
+        }
+        ChunkedPointReader reader(std::cin, n, dim, stream_chunk);
+        auto chosen = dispatch_z(z, [&](auto pz) { return compute_facilities_streaming(reader, facility_cost, hs_choice, pz); });
+        for (const tagged_point& p: read_points(reader, chosen)) {
+            std::cout << p;
+        }
+        std::cout << std::endl;
+        return 0;
+    }
     auto points = load_points(n, dim);
 
-    auto chosen = compute_facilities(dim, points, facility_cost, hs_choice);
+    int solve_dim = dim;
+    auto solve_points = reduce_dimension(solve_dim, points, jl_epsilon, jl_dim);
+    report_skipped_reduction(points.size(), dim, jl_epsilon, jl_dim);
+    auto chosen = dispatch_z(z, [&](auto pz) { return compute_facilities(solve_dim, solve_points, facility_cost, hs_choice, pz); });
     for (auto c: chosen) {
         std::cout << points[c];
     }
@@ -3,8 +3,10 @@
 #include <iostream>
 
 #include "lib/points.hpp"
+#include "lib/util.hpp"
 
 int main(int argc, char const *argv[]) {
+    double z = parse_z(argc, argv);
     std::ifstream solution(getenv("SOLUTION"));
     int n, dim; double facility_cost;
     std::cin >> n >> dim >> facility_cost;
@@ -20,6 +22,6 @@ int main(int argc, char const *argv[]) {
             coords.clear();
         }
     }
-    double cost = solution_cost(points, facilities, facility_cost);
+    double cost = dispatch_z(z, [&](auto pz) { return solution_cost(points, facilities, facility_cost, pz); });
     std::cout << std::setprecision(15) << cost << std::endl;
 }
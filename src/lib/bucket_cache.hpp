@@ -0,0 +1,169 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "points.hpp"
+#include "hashing.hpp"
+#include "eval_composable.hpp"
+#include "timing.hpp"
+#include "instrumentation.hpp"
+
+/// Type of the ball sizes of points of type T (weighted points sum their weights).
+template<IsPoint T>
+using ball_size_t = std::conditional_t<std::is_same_v<T, weighted_point>, ll, int>;
+
+/**
+ * @brief Cache of the bucket tables of ball sizes of a fixed set of points,
+ *        for each hashing scheme (created by `make_hashing_scheme` from its seed) and radius.
+ *
+ * An entry holds the hashes of the points, the sizes of the buckets and the ball sizes evaluated from them,
+ * so a radius evaluated again with the same hashing scheme is served without hashing or evaluating balls.
+ *
+ * Every facility set sweeps the same radii in increasing order, a cyclic scan under which evicting the least
+ * recently used entry always evicts the one needed next. So once the entries take the whole memory budget,
+ * only the least recently used entries of other hashing schemes (or seeds) are evicted, and an entry of the same
+ * scheme that does not fit is not cached: the cache keeps the smallest radii of the scheme in use.
+ * Entries are shared, so an evicted entry stays valid for whoever still holds it.
+ *
+ * @tparam S The type of the ball sizes.
+ */
+template<typename S>
+class BucketTableCache {
+  public:
+    /// Hashes and ball sizes of the points for one hashing scheme and radius.
+    struct entry {
+        std::vector<ull> hashes;  ///< The hash of each point
+        BucketTable<S> sizes;     ///< The size of each bucket
+        std::vector<S> ball_sizes; ///< The size of the approximate ball of each point
+
+        /// The memory taken by the entry, in bytes.
+        size_t bytes() const {
+            return hashes.capacity() * sizeof(ull) + sizes.bytes() + ball_sizes.capacity() * sizeof(S);
+        }
+    };
+
+  private:
+    typedef std::tuple<HashingSchemeChoice, ull, double> key;
+    typedef std::list<std::pair<key, std::shared_ptr<const entry>>> entry_list;
+
+    size_t _budget;
+    size_t _bytes = 0;
+    size_t _hits = 0;
+    size_t _misses = 0;
+    entry_list _entries; ///< Most recently used first
+    std::map<key, typename entry_list::iterator> _index;
+
+  public:
+    /**
+     * @brief Constructs an empty cache.
+     * @param budget The memory budget of the entries, in bytes.
+     */
+    BucketTableCache(size_t budget) : _budget(budget) {}
+
+    size_t size() const { return _entries.size(); }
+    size_t bytes() const { return _bytes; }
+
+    /// The number of calls of `find` that found their entry.
+    size_t hits() const { return _hits; }
+
+    /// The number of calls of `find` that did not find their entry.
+    size_t misses() const { return _misses; }
+
+    /**
+     * @brief Finds an entry and marks it as the most recently used.
+     * @return The entry or NULL if it is not cached.
+     */
+    std::shared_ptr<const entry> find(HashingSchemeChoice hs_choice, ull scheme_seed, double radius) {
+        auto it = _index.find({hs_choice, scheme_seed, radius});
+        if (it == _index.end()) {
+            _misses++;
+            return NULL;
+        }
+        _hits++;
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->second;
+    }
+
+    /**
+     * @brief Caches an entry as the most recently used if it fits in the budget,
+     *        evicting the least recently used entries of other hashing schemes or seeds to make room.
+     * @return Whether the entry is cached.
+     */
+    bool insert(HashingSchemeChoice hs_choice, ull scheme_seed, double radius, std::shared_ptr<const entry> value) {
+        key k = {hs_choice, scheme_seed, radius};
+        if (_index.count(k)) return true;
+        size_t bytes = value->bytes();
+        for (auto it = _entries.end(); _bytes + bytes > _budget && it != _entries.begin(); ) {
+            --it;
+            if (std::get<0>(it->first) == hs_choice && std::get<1>(it->first) == scheme_seed) continue;
+            _bytes -= it->second->bytes();
+            _index.erase(it->first);
+            it = _entries.erase(it);
+            INSTR_COUNT("bucket_cache.evictions", 1);
+        }
+        if (_bytes + bytes > _budget) {
+            INSTR_COUNT("bucket_cache.rejections", 1);
+            return false;
+        }
+        _bytes += bytes;
+        _entries.push_front({k, std::move(value)});
+        _index[k] = _entries.begin();
+        return true;
+    }
+};
+
+/**
+ * @brief Evaluates the sizes of the approximate balls of radius r with the hashing scheme of a seed,
+ *        served from the cache if they were evaluated before (with HashBucketIdentity, see `eval_composable`).
+ *
+ * @param dim The dimension of the space.
+ * @param points The set of points P, always the same for a cache. Their hashes are set by the hashing scheme.
+ * @param radius The radius r determining size of the balls.
+ * @param size The composable function giving the size of a set.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param scheme_seed The seed of the hashing scheme.
+ * @param cache The cache of the points.
+ * @return The cache entry with the ball sizes.
+ */
+template<typename S, IsPoint Point>
+std::shared_ptr<const typename BucketTableCache<S>::entry> cached_ball_sizes(
+    int dim,
+    std::vector<Point>& points,
+    double radius,
+    const Composable::Composable<S>& size,
+    HashingSchemeChoice hs_choice,
+    ull scheme_seed,
+    BucketTableCache<S>& cache
+) {
+    auto cached = cache.find(hs_choice, scheme_seed, radius);
+    if (cached) {
+        INSTR_COUNT("bucket_cache.hits", 1);
+        #pragma omp parallel for
+        for (size_t i=0; i<points.size(); i++) {
+            points[i].hash = cached->hashes[i];
+        }
+        return cached;
+    }
+
+    INSTR_COUNT("bucket_cache.misses", 1);
+    auto hashing_scheme = make_hashing_scheme<S>(hs_choice, dim, radius, scheme_seed);
+    auto computed = std::make_shared<typename BucketTableCache<S>::entry>();
+    computed->hashes.resize(points.size());
+    {
+        phase_timer timer(HashPhase);
+        #pragma omp parallel for
+        for (size_t i=0; i<points.size(); i++) {
+            points[i].hash = computed->hashes[i] = hashing_scheme->hash(points[i]);
+        }
+    }
+    computed->sizes = BucketTable<S>(points.size());
+    aggregate_buckets(points, size, computed->sizes);
+    computed->ball_sizes = eval_balls(points, radius, size, *hashing_scheme, computed->sizes);
+    cache.insert(hs_choice, scheme_seed, radius, computed);
+    return computed;
+}
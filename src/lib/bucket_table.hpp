@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "types.hpp"
+#include "flat_hash_map.hpp"
+
+/**
+ * @brief Represent how buckets are identified in a bucket table.
+ * - HashBucketIdentity identifies a bucket by the 64-bit hash of its cell
+ * - CellBucketIdentity identifies a bucket by its full cell coordinate tuple, the hash only places it in the table
+ */
+enum BucketIdentity {HashBucketIdentity, CellBucketIdentity};
+
+/**
+ * @brief Compact representation of cell coordinate tuples.
+ *
+ * Each coordinate is stored as an offset from the smallest occupied cell coordinate in its dimension,
+ * in a field of 8, 16, 32 or 64 bits (the smallest width fitting the largest offset), packed into 64-bit words.
+ * Cells outside the bounding box of occupied cells have no representation.
+ */
+class CellPacking {
+  private:
+    int _dimension;
+    int _bits;
+    int _words;
+    std::vector<ull> _min_cell;
+    std::vector<ull> _extent;
+
+  public:
+    /**
+     * @brief Constructs the packing for a set of occupied cells.
+     *
+     * @param dim The dimension of the space.
+     * @param cells The coordinates of occupied cells, `dim` consecutive values per cell.
+     */
+    CellPacking(int dim, const std::vector<ull>& cells) : _dimension(dim), _min_cell(dim), _extent(dim) {
+        ull* lo = _min_cell.data();
+        ull* hi = _extent.data();
+        std::fill(lo, lo + dim, std::numeric_limits<ull>::max());
+        std::fill(hi, hi + dim, 0);
+        size_t count = dim > 0 ? cells.size() / dim : 0;
+        if (count > 0) {
+            #pragma omp parallel for reduction(min: lo[:dim]) reduction(max: hi[:dim])
+            for (size_t c=0; c<count; c++) {
+                for (int i=0; i<dim; i++) {
+                    lo[i] = std::min(lo[i], cells[c*dim + i]);
+                    hi[i] = std::max(hi[i], cells[c*dim + i]);
+                }
+            }
+        }
+
+        ull max_extent = 0;
+        for (int i=0; i<dim; i++) {
+            _extent[i] = count ? _extent[i] - _min_cell[i] : 0;
+            max_extent = std::max(max_extent, _extent[i]);
+        }
+        _bits = std::max(8, (int) std::bit_ceil((unsigned) std::bit_width(max_extent)));
+        _words = (dim * _bits + 63) / 64;
+    }
+
+    int dimension() const { return _dimension; }
+    int bits() const { return _bits; }
+    int words() const { return _words; }
+
+    /**
+     * @brief Checks whether a cell lies in the bounding box of occupied cells.
+     * @param cell The cell coordinates.
+     */
+    bool contains(const ull* cell) const {
+        for (int i=0; i<_dimension; i++) {
+            if (cell[i] - _min_cell[i] > _extent[i]) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Packs a cell from the bounding box of occupied cells.
+     * @param cell The cell coordinates.
+     * @param key Output array of `words()` words.
+     */
+    void pack(const ull* cell, ull* key) const {
+        std::fill(key, key + _words, 0);
+        for (int i=0; i<_dimension; i++) {
+            int bit = i * _bits;
+            key[bit / 64] |= (cell[i] - _min_cell[i]) << (bit % 64);
+        }
+    }
+
+    /**
+     * @brief Checks whether a packed key represents a cell from the bounding box of occupied cells.
+     * @param key The packed key.
+     * @param cell The cell coordinates.
+     */
+    bool matches(const ull* key, const ull* cell) const {
+        ull mask = _bits == 64 ? std::numeric_limits<ull>::max() : (1ULL << _bits) - 1;
+        for (int i=0; i<_dimension; i++) {
+            int bit = i * _bits;
+            if (((key[bit / 64] >> (bit % 64)) & mask) != cell[i] - _min_cell[i]) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Table of values of a composable function on buckets of a hashing scheme.
+ *
+ * With HashBucketIdentity, buckets are keyed by their hash, so cells with colliding hashes share a value.
+ * With CellBucketIdentity, the hash only chooses the chain of buckets to search and buckets are told apart
+ * by their packed cell coordinates, so no two cells ever share a value.
+ *
+ * @tparam T The type of the values.
+ */
+template<typename T>
+class BucketTable {
+  private:
+    static constexpr size_t _none = std::numeric_limits<size_t>::max();
+
+    bool _exact;
+    FlatHashMap<T> _by_hash;
+
+    // Used only with CellBucketIdentity
+    CellPacking _packing;
+    FlatHashMap<size_t> _heads;
+    std::vector<ull> _keys;
+    std::vector<T> _values;
+    std::vector<size_t> _next;
+
+    const T* find_exact(ull hash, const ull* cell) const {
+        if (!_packing.contains(cell)) return NULL;
+        const size_t* head = _heads.find(hash);
+        for (size_t entry = head ? *head : _none; entry != _none; entry = _next[entry]) {
+            if (_packing.matches(&_keys[entry * _packing.words()], cell)) return &_values[entry];
+        }
+        return NULL;
+    }
+
+  public:
+    /**
+     * @brief Constructs an empty table identifying buckets by their hash.
+     * @param expected_size The number of buckets to allocate space for.
+     */
+    BucketTable(size_t expected_size = 0)
+        : _exact(false), _by_hash(expected_size), _packing(0, {}) {}
+
+    /**
+     * @brief Constructs an empty table identifying buckets by their cell coordinates.
+     * @param dim The dimension of the space.
+     * @param cells The coordinates of all cells that will be inserted, `dim` consecutive values per cell.
+     */
+    BucketTable(int dim, const std::vector<ull>& cells)
+        : _exact(true), _packing(dim, cells), _heads(cells.size() / std::max(dim, 1)) {}
+
+    bool exact() const { return _exact; }
+    size_t size() const { return _exact ? _values.size() : _by_hash.size(); }
+
+    /// The memory taken by the table, in bytes.
+    size_t bytes() const {
+        return _by_hash.bytes() + _heads.bytes() + _keys.capacity() * sizeof(ull) + _values.capacity() * sizeof(T) + _next.capacity() * sizeof(size_t);
+    }
+
+    /**
+     * @brief Gets the value of a bucket, inserting a given value if the bucket is missing.
+     * @param hash The hash of the bucket.
+     * @param cell The cell coordinates of the bucket (ignored with HashBucketIdentity).
+     * @param default_value The value to insert if the bucket is missing.
+     * @return Reference to the stored value (valid until the next insertion).
+     */
+    T& get_or_insert(ull hash, const ull* cell, const T& default_value) {
+        if (!_exact) return _by_hash.get_or_insert(hash, default_value);
+
+        size_t& head = _heads.get_or_insert(hash, _none);
+        for (size_t entry = head; entry != _none; entry = _next[entry]) {
+            if (_packing.matches(&_keys[entry * _packing.words()], cell)) return _values[entry];
+        }
+        size_t entry = _values.size();
+        _keys.resize(_keys.size() + _packing.words());
+        _packing.pack(cell, &_keys[entry * _packing.words()]);
+        _values.push_back(default_value);
+        _next.push_back(head);
+        head = entry;
+        return _values[entry];
+    }
+
+    /**
+     * @brief Finds the value of a bucket.
+     * @param hash The hash of the bucket.
+     * @param cell The cell coordinates of the bucket (ignored with HashBucketIdentity).
+     * @return Pointer to the value or NULL if the bucket is missing.
+     */
+    const T* find(ull hash, const ull* cell) const {
+        return _exact ? find_exact(hash, cell) : _by_hash.find(hash);
+    }
+
+    /**
+     * @brief Hints that a bucket will be looked up soon.
+     * @param hash The hash of the bucket.
+     */
+    void prefetch(ull hash) const {
+        if (_exact) _heads.prefetch(hash);
+        else        _by_hash.prefetch(hash);
+    }
+
+    /**
+     * @brief Finds values of several buckets, overlapping their memory accesses.
+     * @param hashes The hashes of the buckets.
+     * @param cells The cell coordinates of the buckets, `dim` consecutive values per bucket.
+     * @param count The number of buckets.
+     * @param values Output array of `count` pointers to the values (NULL for missing buckets).
+     */
+    void find_batch(const ull* hashes, const ull* cells, size_t count, const T** values) const {
+        if (!_exact) {
+            _by_hash.find_batch(hashes, count, values);
+            return;
+        }
+        for (size_t i=0; i<count; i++) {
+            _heads.prefetch(hashes[i]);
+        }
+        for (size_t i=0; i<count; i++) {
+            values[i] = find_exact(hashes[i], cells + i * _packing.dimension());
+        }
+    }
+};
+
+/**
+ * @brief Set of buckets identified like in a `BucketTable`: by their hash, or by their cell coordinates
+ *        when the table is exact, so that cells with colliding hashes are told apart.
+ */
+class BucketSet {
+  private:
+    bool _exact;
+    int _dimension;
+    std::unordered_set<ull> _hashes;
+    std::set<std::vector<ull>> _cells;
+
+  public:
+    /**
+     * @param exact Whether buckets are identified by their cell coordinates.
+     * @param dim The number of coordinates of a cell.
+     */
+    BucketSet(bool exact, int dim) : _exact(exact), _dimension(dim) {}
+
+    size_t size() const { return _exact ? _cells.size() : _hashes.size(); }
+
+    /**
+     * @brief Adds a bucket.
+     * @param hash The hash of the bucket.
+     * @param cell The cell coordinates of the bucket (ignored unless exact).
+     * @return Whether the bucket was not in the set.
+     */
+    bool insert(ull hash, const ull* cell) {
+        if (!_exact) return _hashes.insert(hash).second;
+        return _cells.emplace(cell, cell + _dimension).second;
+    }
+};
@@ -1,35 +1,50 @@
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <limits>
+#include <map>
 #include <assert.h>
+#include <omp.h>
 
 #include "constants.hpp"
 #include "points.hpp"
+#include "random.hpp"
+#include "composable.hpp"
+#include "eval_composable.hpp"
 #include "facility_set.hpp"
+#include "clustering.hpp"
 #include "pow_z.hpp"
+#include "timing.hpp"
+#include "instrumentation.hpp"
+#include "tracing.hpp"
 
 typedef unsigned long long ull;
 
-std::vector<weighted_point> group_centers(const std::vector<tagged_point>& points, const std::vector<tagged_point>& approx_k_facilities) {
+template<IsPoint T>
+std::vector<weighted_point> group_centers(const std::vector<T>& points, const std::vector<tagged_point>& approx_k_facilities) {
     std::vector<weighted_point> weighted_points;
     for (auto p: approx_k_facilities) {
         weighted_points.push_back(weighted_point(p));
     }
-    for (auto p: points) {
-        weighted_points[min_dist(p, approx_k_facilities).index].weight++;
+    for (const T& p: points) {
+        weighted_points[min_dist(p, approx_k_facilities).index].weight += weight_of(p);
     }
     return weighted_points;
 }
 
+template std::vector<weighted_point> group_centers(const std::vector<tagged_point>&, const std::vector<tagged_point>&);
+template std::vector<weighted_point> group_centers(const std::vector<weighted_point>&, const std::vector<tagged_point>&);
 
-std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>& weighted_points, const int k, const double mu, const double guess) {
+
+template<IsPowZ P>
+std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>& weighted_points, const int k, const double mu, const double guess, P pz) {
     assert(guess > 0);
     std::vector<int> result;
     std::vector<tagged_point> centers;
     for (size_t i=0; i<weighted_points.size(); i++) {
         weighted_point p = weighted_points[i].second;
         double md = min_dist(p, centers).dist;
-        if (result.size() == 0 || POWZ(md) * p.weight > POWZ(2) * guess / (mu*k)) {
+        if (result.size() == 0 || pz.pow(md) * p.weight > pz.pow(2) * guess / (mu*k)) {
             result.push_back(weighted_points[i].first);
             centers.push_back(p);
         }
@@ -37,29 +52,150 @@ std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_poi
     return result;
 }
 
-std::vector<int> compute_clusters_seq(int dim, std::vector<tagged_point> points, const int k, HashingSchemeChoice hs_choice, const double mu=0.1) {
-    assert(k >= 1);
-    assert(0.0 < mu && mu < 1.0);
+/// Total number of points represented by a set of (possibly weighted) points.
+template<IsPoint T>
+static double total_weight(const std::vector<T>& points) {
+    double total = 0;
+    for (const T& p: points) {
+        total += weight_of(p);
+    }
+    return total;
+}
 
-    double opt_guess = -1;
-    double min_cost = std::numeric_limits<double>::infinity();
-    auto [min_d, max_d] = aspect_ratio_approx(dim, points);
-    min_d = std::max(min_d, 1.0 / scale);
-    double small_gamma = pow(get_gamma(hs_choice, dim), small_gamma_exp_mul[hs_choice]*Z);
-    for (double guess=POWZ(min_d); guess < points.size()*POWZ(max_d); guess*=2) {
+/**
+ * @brief Computes the facility sets of the guesses of a run on the same points,
+ *        sharing the ball sizes of each radius among them (see `BucketTableCache`).
+ */
+template<IsPoint T>
+struct facility_guesses {
+    std::unique_ptr<BucketTableCache<ball_size_t<T>>> owned_cache;
+    BucketTableCache<ball_size_t<T>>* cache = NULL;
+    ull scheme_seed = 0;
+
+    /**
+     * @param shared_cache The cache to use, if NULL a new one within `bucket_cache_budget`
+     *                     (none if the budget is 0 or buckets are identified by cells).
+     */
+    facility_guesses(BucketTableCache<ball_size_t<T>>* shared_cache = NULL) : cache(shared_cache) {
+        if (cache == NULL && bucket_cache_budget > 0 && bucket_identity == HashBucketIdentity) {
+            owned_cache = std::make_unique<BucketTableCache<ball_size_t<T>>>(bucket_cache_budget);
+            cache = owned_cache.get();
+        }
+        if (cache != NULL) scheme_seed = randRange(0ULL, std::numeric_limits<ull>::max());
+    }
+
+    template<IsPowZ P>
+    std::vector<int> facilities(int dim, const std::vector<T>& points, double facility_cost, HashingSchemeChoice hs_choice, P pz) {
+        if (cache == NULL) return compute_facilities(dim, points, facility_cost, hs_choice, pz);
+        return compute_facilities(dim, points, facility_cost, hs_choice, pz, *cache, scheme_seed);
+    }
+};
+
+/**
+ * @brief Finds for each k the guess of the optimal cost whose facility set (for facility cost guess/k) is cheapest
+ *        among those with at most 2𝛾k facilities.
+ *
+ * The facility costs swept are the guesses 2^i·min_d^z divided by the largest k. They serve every k alike,
+ * as guesses k times them, so the facility set of each facility cost is computed once for all of them.
+ *
+ * A k for which every facility set has more than 2𝛾k facilities, which can happen on few points, takes the guess
+ * with the fewest facilities instead.
+ * The range of guesses of every k is not empty if there are two points at different positions.
+ *
+ * @param ks The numbers of clusters.
+ * @param cost Function giving the cost of facility indexes for a facility cost.
+ * @return The facility cost (best guess divided by k) of each k.
+ */
+template<IsPoint T, IsPowZ P, typename Cost>
+static std::vector<double> best_facility_costs(int dim, const std::vector<T>& points, const std::vector<int>& ks, HashingSchemeChoice hs_choice, P pz, double min_d, double max_d, facility_guesses<T>& guesses, Cost cost) {
+    int k_min = *std::min_element(ks.begin(), ks.end());
+    int k_max = *std::max_element(ks.begin(), ks.end());
+    std::vector<double> best_costs(ks.size(), -1), fallback_costs(ks.size(), -1);
+    std::vector<double> min_costs(ks.size(), std::numeric_limits<double>::infinity());
+    std::vector<size_t> min_sizes(ks.size(), std::numeric_limits<size_t>::max());
+    double small_gamma = pow(get_gamma(hs_choice, dim), small_gamma_exp_mul[hs_choice]*pz.z());
+    double max_guess = total_weight(points)*pz.pow(max_d);
+    for (double guess=pz.pow(min_d); guess * ((double) k_min / k_max) < max_guess; guess*=2) {
         assert(guess > 0);
-        double facility_cost = guess / k;
-        auto facilities_indexes = compute_facilities(dim, points, facility_cost, hs_choice);
-        if (facilities_indexes.size() > 2*small_gamma*k) continue;
-        double cost = solution_cost(points, facilities_indexes, facility_cost);
-        if (min_cost > cost) {
-            min_cost = cost;
-            opt_guess = guess;
+        double facility_cost = guess / k_max;
+        auto facilities_indexes = guesses.facilities(dim, points, facility_cost, hs_choice, pz);
+        INSTR_COUNT("compute_clusters_seq.guesses", 1);
+        for (size_t i=0; i<ks.size(); i++) {
+            // Guesses of smaller k start up to half below min_d^z so that they keep doubling from it
+            double k_guess = guess * ((double) ks[i] / k_max);
+            if (2*k_guess <= pz.pow(min_d) || k_guess >= max_guess) continue;
+            if (facilities_indexes.size() < min_sizes[i]) {
+                min_sizes[i] = facilities_indexes.size();
+                fallback_costs[i] = facility_cost;
+            }
+        }
+        if (facilities_indexes.size() > 2*small_gamma*k_max) {
+            INSTR_COUNT("compute_clusters_seq.guesses_rejected", 1);
+            continue;
+        }
+        double guess_cost = cost(facilities_indexes, facility_cost);
+        for (size_t i=0; i<ks.size(); i++) {
+            double k_guess = guess * ((double) ks[i] / k_max);
+            if (2*k_guess <= pz.pow(min_d) || k_guess >= max_guess || facilities_indexes.size() > 2*small_gamma*ks[i]) continue;
+            if (min_costs[i] > guess_cost) {
+                min_costs[i] = guess_cost;
+                best_costs[i] = facility_cost;
+            }
         }
     }
-    assert(opt_guess != -1);
-    auto facilities_indexes = compute_facilities(dim, points, opt_guess / k, hs_choice);
+    for (size_t i=0; i<ks.size(); i++) {
+        if (best_costs[i] != -1) continue;
+        // Facility sets are random, on few points every guess can have too many facilities
+        INSTR_COUNT("compute_clusters_seq.guesses_fallback", 1);
+        assert(fallback_costs[i] != -1);
+        best_costs[i] = fallback_costs[i];
+    }
+    return best_costs;
+}
 
+/**
+ * @brief Runs the sequential algorithm for weak coresets for every guess 2^i·min_d^z
+ *        and gives the cheapest result with less than (1+𝜇)k centers.
+ *
+ * @param weighted_points The coreset sorted by decreasing weight.
+ * @param cost Function giving the cost of centers as original indexes.
+ */
+template<IsPowZ P, typename Cost>
+static std::vector<int> best_weak_coreset(const std::vector<std::pair<int, weighted_point>>& weighted_points, int k, double mu, double min_d, int max_pow2, P pz, Cost cost) {
+    INSTR_COUNT("compute_clusters_seq.weak_coreset_guesses", max_pow2);
+    std::vector<double> costs(max_pow2, std::numeric_limits<double>::infinity());
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("weak_coresets");
+        #pragma omp for nowait
+        for (int pow2 = 0; pow2 < max_pow2; pow2++) {
+            double guess = pz.pow(min_d) * pow(2.0, pow2);
+            std::vector<int> result = weak_coresets_seq(weighted_points, k, mu, guess, pz);
+            if (result.size() < (1.0 + mu)*k)
+                costs[pow2] = cost(result);
+        }
+    }
+    int best_pow2 = std::min_element(costs.begin(), costs.end()) - costs.begin();
+    assert(best_pow2 != std::numeric_limits<double>::infinity());
+
+    return weak_coresets_seq(weighted_points, k, mu, pz.pow(min_d) * pow(2.0, best_pow2), pz);
+}
+
+static void sort_by_weight(std::vector<std::pair<int, weighted_point>>& weighted_points) {
+    std::sort(
+        weighted_points.begin(),
+        weighted_points.end(),
+        [](auto& wp1, auto& wp2) { return wp1.second.weight > wp2.second.weight; }
+    );
+}
+
+/**
+ * @brief Moves every point (with its weight) to its nearest facility.
+ *
+ * @return The coreset of weighted points with indexes of the facilities into the set of points.
+ */
+template<IsPoint T>
+static std::vector<std::pair<int, weighted_point>> move_to_facilities(const std::vector<T>& points, const std::vector<int>& facilities_indexes) {
     std::vector<tagged_point> approx_k_facilities;
     approx_k_facilities.reserve(facilities_indexes.size());
     for (int i: facilities_indexes) {
@@ -71,24 +207,747 @@ std::vector<int> compute_clusters_seq(int dim, std::vector<tagged_point> points,
     for (size_t i=0; i<wp.size(); i++) {
         weighted_points.push_back({facilities_indexes[i], wp[i]});
     }
+    return weighted_points;
+}
 
-    std::sort(
-        weighted_points.begin(),
-        weighted_points.end(),
-        [](auto& wp1, auto& wp2) { return wp1.second.weight > wp2.second.weight; }
-    );
+/**
+ * @brief Reduces a set of points to a coreset (Section 5.1): computes facilities for the best guess
+ *        and moves every point (with its weight) to its nearest facility.
+ *
+ * @param cache The cache of ball sizes of the points, NULL for one of this call only.
+ * @return The coreset of weighted points with indexes of the facilities into the set of points.
+ */
+template<IsPoint T, IsPowZ P>
+static std::vector<std::pair<int, weighted_point>> reduce_to_coreset(int dim, const std::vector<T>& points, int k, HashingSchemeChoice hs_choice, P pz, double min_d, double max_d, BucketTableCache<ball_size_t<T>>* cache) {
+    facility_guesses<T> guesses(cache);
+    double opt_facility_cost = best_facility_costs(dim, points, {k}, hs_choice, pz, min_d, max_d, guesses, [&](const std::vector<int>& facilities_indexes, double facility_cost) {
+        return solution_cost(points, facilities_indexes, facility_cost, pz);
+    })[0];
+    auto facilities_indexes = guesses.facilities(dim, points, opt_facility_cost, hs_choice, pz);
 
-    int max_pow2 = log2(points.size()*POWZ(max_d) / POWZ(min_d)) + 1;
-    std::vector<double> costs(max_pow2, std::numeric_limits<double>::infinity());
-    #pragma omp parallel for
-    for (int pow2 = 0; pow2 < max_pow2; pow2++) {
-        double guess = POWZ(min_d) * pow(2.0, pow2);
-        std::vector<int> result = weak_coresets_seq(weighted_points, k, mu, guess);
-        if (result.size() < (1.0 + mu)*k)
-            costs[pow2] = solution_cost(points, result, 0);
+    phase_timer timer(SelectionPhase);
+    return move_to_facilities(points, facilities_indexes);
+}
+
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_clusters_seq(int dim, std::vector<T> points, const int k, HashingSchemeChoice hs_choice, P pz, const double mu) {
+    std::pair<double, double> aspect_ratio = aspect_ratio_approx(dim, points);
+    return compute_clusters_seq(dim, std::move(points), k, hs_choice, pz, aspect_ratio, NULL, mu);
+}
+
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_clusters_seq(int dim, std::vector<T> points, const int k, HashingSchemeChoice hs_choice, P pz, std::pair<double, double> aspect_ratio, BucketTableCache<ball_size_t<T>>* cache, const double mu) {
+    INSTR_TIMER("compute_clusters_seq");
+    assert(k >= 1);
+    assert(0.0 < mu && mu < 1.0);
+
+    auto [min_d, max_d] = aspect_ratio;
+    min_d = std::max(min_d, 1.0 / scale);
+    auto weighted_points = reduce_to_coreset(dim, points, k, hs_choice, pz, min_d, max_d, cache);
+
+    phase_timer timer(SelectionPhase);
+    sort_by_weight(weighted_points);
+
+    INSTR_RECORD("compute_clusters_seq.coreset_size", weighted_points.size());
+
+    int max_pow2 = log2(total_weight(points)*pz.pow(max_d) / pz.pow(min_d)) + 1;
+    return best_weak_coreset(weighted_points, k, mu, min_d, max_pow2, pz, [&](const std::vector<int>& result) {
+        return solution_cost(points, result, 0, pz);
+    });
+}
+
+template<IsPoint T, IsPowZ P>
+std::vector<clustering_solution> compute_clusters_multi_k(int dim, const std::vector<T>& points, const std::vector<int>& ks, HashingSchemeChoice hs_choice, P pz, const double mu) {
+    return compute_clusters_multi_k(dim, points, ks, hs_choice, pz, aspect_ratio_approx(dim, points), NULL, mu);
+}
+
+template<IsPoint T, IsPowZ P>
+std::vector<clustering_solution> compute_clusters_multi_k(int dim, const std::vector<T>& points, const std::vector<int>& ks, HashingSchemeChoice hs_choice, P pz, std::pair<double, double> aspect_ratio, BucketTableCache<ball_size_t<T>>* cache, const double mu) {
+    INSTR_TIMER("compute_clusters_multi_k");
+    assert(!ks.empty());
+    for (int k: ks) {
+        assert(k >= 1);
     }
-    int best_pow2 = std::min_element(costs.begin(), costs.end()) - costs.begin();
-    assert(best_pow2 != std::numeric_limits<double>::infinity());
+    assert(0.0 < mu && mu < 1.0);
+
+    auto [min_d, max_d] = aspect_ratio;
+    min_d = std::max(min_d, 1.0 / scale);
+    facility_guesses<T> guesses(cache);
+    std::vector<double> facility_costs = best_facility_costs(dim, points, ks, hs_choice, pz, min_d, max_d, guesses, [&](const std::vector<int>& facilities_indexes, double facility_cost) {
+        return solution_cost(points, facilities_indexes, facility_cost, pz);
+    });
+
+    // Coresets by facility cost, shared by the k with the same best guess
+    std::map<double, std::vector<std::pair<int, weighted_point>>> coresets;
+    int max_pow2 = log2(total_weight(points)*pz.pow(max_d) / pz.pow(min_d)) + 1;
+    std::vector<clustering_solution> solutions;
+    solutions.reserve(ks.size());
+    for (size_t i=0; i<ks.size(); i++) {
+        auto coreset = coresets.find(facility_costs[i]);
+        if (coreset == coresets.end()) {
+            auto facilities_indexes = guesses.facilities(dim, points, facility_costs[i], hs_choice, pz);
+            phase_timer timer(SelectionPhase);
+            auto weighted_points = move_to_facilities(points, facilities_indexes);
+            sort_by_weight(weighted_points);
+            INSTR_COUNT("compute_clusters_multi_k.coresets", 1);
+            coreset = coresets.emplace(facility_costs[i], std::move(weighted_points)).first;
+        }
+
+        phase_timer timer(SelectionPhase);
+        auto cost = [&](const std::vector<int>& result) {
+            return solution_cost(points, result, 0, pz);
+        };
+        auto centers = best_weak_coreset(coreset->second, ks[i], mu, min_d, max_pow2, pz, cost);
+        double centers_cost = cost(centers);
+        solutions.push_back({ks[i], std::move(centers), centers_cost});
+    }
+    return solutions;
+}
+
+/**
+ * @brief Reduces a coreset of weighted points with their original indexes to a smaller one as in `compute_clusters_seq`.
+ */
+template<IsPowZ P>
+static std::vector<std::pair<ll, weighted_point>> reduce_coreset(int dim, const std::vector<std::pair<ll, weighted_point>>& weighted_points, int k, HashingSchemeChoice hs_choice, P pz) {
+    if ((ll) weighted_points.size() <= k) return weighted_points;
+
+    std::vector<weighted_point> points;
+    points.reserve(weighted_points.size());
+    for (const auto& [_, p]: weighted_points) {
+        points.push_back(p);
+    }
+    auto [min_d, max_d] = aspect_ratio_approx(dim, points);
+    min_d = std::max(min_d, 1.0 / scale);
+
+    std::vector<std::pair<ll, weighted_point>> coreset;
+    for (auto& [i, p]: reduce_to_coreset(dim, points, k, hs_choice, pz, min_d, max_d, NULL)) {
+        coreset.push_back({weighted_points[i].first, std::move(p)});
+    }
+    return coreset;
+}
+
+template<IsPowZ P>
+std::vector<std::pair<ll, weighted_point>> merge_reduce_coreset(
+    int dim,
+    std::function<bool(std::vector<weighted_point>&)> next_chunk,
+    int k,
+    HashingSchemeChoice hs_choice,
+    P pz
+) {
+    assert(k >= 1);
+
+    // Coreset of 2^level leaves at each level, like digits of a binary counter
+    std::vector<std::vector<std::pair<ll, weighted_point>>> levels;
+    auto insert = [&](std::vector<std::pair<ll, weighted_point>> coreset) {
+        size_t level = 0;
+        for (; level < levels.size() && !levels[level].empty(); level++) {
+            coreset.insert(coreset.end(), levels[level].begin(), levels[level].end());
+            levels[level].clear();
+            coreset = reduce_coreset(dim, coreset, k, hs_choice, pz);
+        }
+        if (level == levels.size()) levels.emplace_back();
+        levels[level] = std::move(coreset);
+    };
 
-    return weak_coresets_seq(weighted_points, k, mu, POWZ(min_d) * pow(2.0, best_pow2));
+    // Up to one chunk per thread is reduced in parallel. Each is seeded in advance from a generator of its own,
+    // and the generator of the thread is restored after it, so results do not depend on the number of threads.
+    ll offset = 0;
+    std::mt19937 leaf_seeds(randRange(0ULL, std::numeric_limits<ull>::max()));
+    std::vector<std::vector<std::pair<ll, weighted_point>>> leaves(omp_get_max_threads());
+    std::vector<ull> seeds(leaves.size());
+    std::vector<weighted_point> chunk;
+    bool more = true;
+    while (more) {
+        size_t count = 0;
+        while (count < leaves.size() && (more = next_chunk(chunk))) {
+            if (chunk.empty()) continue;
+            leaves[count].clear();
+            for (const weighted_point& p: chunk) {
+                leaves[count].push_back({offset++, p});
+            }
+            seeds[count++] = std::uniform_int_distribution<ull>()(leaf_seeds);
+        }
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i=0; i<count; i++) {
+            thread_seed_guard guard(seeds[i]);
+            leaves[i] = reduce_coreset(dim, leaves[i], k, hs_choice, pz);
+        }
+        for (size_t i=0; i<count; i++) {
+            insert(std::move(leaves[i]));
+        }
+    }
+
+    std::vector<std::pair<ll, weighted_point>> root;
+    for (const auto& coreset: levels) {
+        root.insert(root.end(), coreset.begin(), coreset.end());
+    }
+    assert(!root.empty());
+    if (levels.size() > 1) root = reduce_coreset(dim, root, k, hs_choice, pz);
+    INSTR_RECORD("compute_clusters_merge_reduce.levels", levels.size());
+    INSTR_RECORD("compute_clusters_merge_reduce.coreset_size", root.size());
+    return root;
+}
+
+template<IsPowZ P>
+std::vector<ll> compute_clusters_merge_reduce(
+    int dim,
+    std::function<bool(std::vector<weighted_point>&)> next_chunk,
+    int k,
+    HashingSchemeChoice hs_choice,
+    P pz,
+    double mu
+) {
+    INSTR_TIMER("compute_clusters_merge_reduce");
+    assert(0.0 < mu && mu < 1.0);
+    std::vector<std::pair<ll, weighted_point>> root = merge_reduce_coreset(dim, next_chunk, k, hs_choice, pz);
+
+    phase_timer timer(SelectionPhase);
+    // The weak coresets index the root, whose size fits an int, and the centers are mapped back to the input
+    std::vector<weighted_point> root_points;
+    std::vector<std::pair<int, weighted_point>> positions;
+    root_points.reserve(root.size());
+    positions.reserve(root.size());
+    for (size_t i=0; i<root.size(); i++) {
+        root_points.push_back(root[i].second);
+        positions.push_back({(int) i, root[i].second});
+    }
+    sort_by_weight(positions);
+    auto [min_d, max_d] = aspect_ratio_approx(dim, root_points);
+    min_d = std::max(min_d, 1.0 / scale);
+
+    int max_pow2 = log2(total_weight(root_points)*pz.pow(max_d) / pz.pow(min_d)) + 1;
+    std::vector<int> centers = best_weak_coreset(positions, k, mu, min_d, max_pow2, pz, [&](const std::vector<int>& result) {
+        return solution_cost(root_points, result, 0, pz);
+    });
+    std::vector<ll> indexes;
+    indexes.reserve(centers.size());
+    for (int i: centers) {
+        indexes.push_back(root[i].first);
+    }
+    return indexes;
+}
+
+template<IsPowZ P>
+std::vector<int> compute_clusters_merge_reduce(int dim, const std::vector<weighted_point>& points, int k, HashingSchemeChoice hs_choice, P pz, size_t chunk_size, double mu) {
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    size_t position = 0;
+    std::vector<ll> indexes = compute_clusters_merge_reduce(dim, [&](std::vector<weighted_point>& chunk) {
+        if (position >= points.size()) return false;
+        size_t end = std::min(points.size(), position + chunk_size);
+        chunk.assign(points.begin() + position, points.begin() + end);
+        position = end;
+        return true;
+    }, k, hs_choice, pz, mu);
+    return std::vector<int>(indexes.begin(), indexes.end());
+}
+
+template<IsPowZ P>
+IncrementalClustering<P>::IncrementalClustering(int dim, const std::vector<tagged_point>& points, int k, HashingSchemeChoice hs_choice, P pz, double mu)
+    : _dimension(dim), _k(k), _hs_choice(hs_choice), _pz(pz), _mu(mu), _min_coords(dim), _max_coords(dim) {
+    INSTR_TIMER("incremental_clustering");
+    assert(k >= 1);
+    assert(0.0 < mu && mu < 1.0);
+    assert(!points.empty());
+
+    auto [min_d, max_d] = aspect_ratio_approx(dim, points);
+    _min_d = std::max(min_d, 1.0 / scale);
+    facility_guesses<tagged_point> guesses;
+    _facility_cost = best_facility_costs(dim, points, {k}, hs_choice, pz, _min_d, max_d, guesses, [&](const std::vector<int>& facilities_indexes, double facility_cost) {
+        return solution_cost(points, facilities_indexes, facility_cost, pz);
+    })[0];
+
+    _beta = beta_mul[hs_choice] * 3.0 * get_gamma(hs_choice, dim);
+    double alpha = 3 * _beta * _beta;
+    _tau = pow(alpha * _beta, tau_exp_mul[hs_choice]*pz.z());
+    for (int d=0; d<dim; d++) {
+        _min_coords[d] = std::numeric_limits<ll>::max();
+        _max_coords[d] = std::numeric_limits<ll>::min();
+    }
+    insert(points);
 }
+
+template<IsPowZ P>
+double IncrementalClustering<P>::threshold(double radius) const {
+    return _facility_cost / (2 * _pz.pow(_beta) * _pz.pow(radius));
+}
+
+template<IsPowZ P>
+typename IncrementalClustering<P>::radius_level IncrementalClustering<P>::make_level(double radius) const {
+    return {
+        radius,
+        make_hashing_scheme<int>(_hs_choice, _dimension, radius),
+        make_hashing_scheme<ull>(_hs_choice, _dimension, radius),
+        BucketTable<int>(),
+        BucketTable<ull>(),
+        {},
+        {}
+    };
+}
+
+template<IsPowZ P>
+void IncrementalClustering<P>::aggregate(radius_level& level, size_t begin, size_t end) {
+    std::vector<ull> size_hashes(end - begin);
+    level.label_hashes.resize(end);
+    {
+        phase_timer timer(HashPhase);
+        #pragma omp parallel for
+        for (size_t i=begin; i<end; i++) {
+            size_hashes[i - begin] = level.size_scheme->hash(_points[i]);
+            level.label_hashes[i] = level.label_scheme->hash(_points[i]);
+        }
+    }
+    phase_timer timer(AggregatePhase);
+    for (size_t i=begin; i<end; i++) {
+        int& size = level.sizes.get_or_insert(size_hashes[i - begin], NULL, Composable::Size.empty_value);
+        size = Composable::Size.compose(size, Composable::Size.evaluate(_points[i]));
+        ull label = Composable::MinLabelValue.evaluate(_points[i]);
+        ull& min_label = level.min_labels.get_or_insert(level.label_hashes[i], NULL, Composable::MinLabelValue.empty_value);
+        min_label = Composable::MinLabelValue.compose(min_label, label);
+        // Older labels above the new one expire before it, so they never become the minimum again
+        std::vector<ull>& queue = level.label_queues[level.label_hashes[i]];
+        while (!queue.empty() && queue.back() > label) queue.pop_back();
+        queue.push_back(label);
+    }
+}
+
+/**
+ * Removes the first `count` points from the bucket tables of a level. Sizes are inverted,
+ * buckets that lose their minimum label take the next label of their queue.
+ */
+template<IsPowZ P>
+void IncrementalClustering<P>::remove(radius_level& level, size_t count) {
+    std::vector<ull> size_hashes(count);
+    {
+        phase_timer timer(HashPhase);
+        #pragma omp parallel for
+        for (size_t i=0; i<count; i++) {
+            size_hashes[i] = level.size_scheme->hash(_points[i]);
+        }
+    }
+    phase_timer timer(AggregatePhase);
+    for (size_t i=0; i<count; i++) {
+        int& size = level.sizes.get_or_insert(size_hashes[i], NULL, Composable::Size.empty_value);
+        size = Composable::Size.remove(size, Composable::Size.evaluate(_points[i]));
+        ull hash = level.label_hashes[i];
+        auto queue = level.label_queues.find(hash);
+        assert(queue != level.label_queues.end());
+        // The oldest point of a bucket is the first of its queue if it still is a candidate
+        if (queue->second.front() != _points[i].label) continue;
+        queue->second.erase(queue->second.begin());
+        ull& min_label = level.min_labels.get_or_insert(hash, NULL, Composable::MinLabelValue.empty_value);
+        if (queue->second.empty()) {
+            min_label = Composable::MinLabelValue.empty_value;
+            level.label_queues.erase(queue);
+        } else {
+            min_label = queue->second.front();
+        }
+    }
+    level.label_hashes.erase(level.label_hashes.begin(), level.label_hashes.begin() + count);
+}
+
+/**
+ * For each of the first `count` points, the lowest level whose ball may contain one of the changed points
+ * (no higher than the chosen level), -1 if there is none. Points whose ball contains all points get 0.
+ */
+template<IsPowZ P>
+std::vector<int> IncrementalClustering<P>::touched_levels(const std::vector<tagged_point>& changed, size_t count) const {
+    std::vector<double> extents;
+    for (const radius_level& level: _radius_levels) {
+        extents.push_back(std::max(level.size_scheme->ball_extent(level.radius), level.label_scheme->ball_extent(level.radius)));
+    }
+    for (size_t j=1; j<extents.size(); j++) {
+        extents[j] = std::max(extents[j], extents[j-1]);
+    }
+
+    // Changed points sorted along the axis of their largest spread: only those whose coordinate on it
+    // is within the extent of the chosen level of a point can be within that extent of it
+    int axis = 0;
+    ll max_spread = -1;
+    for (int d=0; d<_dimension; d++) {
+        auto [min_p, max_p] = std::minmax_element(changed.begin(), changed.end(), [d](const tagged_point& p, const tagged_point& q) {
+            return p[d] < q[d];
+        });
+        if (max_p->coords[d] - min_p->coords[d] > max_spread) {
+            max_spread = max_p->coords[d] - min_p->coords[d];
+            axis = d;
+        }
+    }
+    std::vector<tagged_point> sorted(changed);
+    std::sort(sorted.begin(), sorted.end(), [axis](const tagged_point& p, const tagged_point& q) {
+        return p[axis] < q[axis];
+    });
+    std::vector<double> changed_coords = scaled_coords(_dimension, sorted);
+    std::vector<double> keys(sorted.size());
+    for (size_t f=0; f<sorted.size(); f++) {
+        keys[f] = changed_coords[f*_dimension + axis];
+    }
+
+    std::vector<int> from(count, -1);
+    #pragma omp parallel
+    {
+        std::vector<double> p(_dimension);
+        #pragma omp for schedule(dynamic, 256)
+        for (size_t i=0; i<count; i++) {
+            if (_levels[i] == -1) {
+                from[i] = 0;
+                continue;
+            }
+            for (int d=0; d<_dimension; d++) {
+                p[d] = (double) _points[i][d] / scale;
+            }
+            double extent = extents[_levels[i]];
+            double min_dist2 = std::numeric_limits<double>::infinity();
+            size_t f = std::lower_bound(keys.begin(), keys.end(), p[axis] - extent) - keys.begin();
+            for (; f<keys.size() && keys[f] <= p[axis] + extent; f++) {
+                const double* q = &changed_coords[f*_dimension];
+                double dist2 = 0;
+                #pragma omp simd reduction(+: dist2)
+                for (int d=0; d<_dimension; d++) {
+                    double delta = p[d] - q[d];
+                    dist2 += delta*delta;
+                }
+                min_dist2 = std::min(min_dist2, dist2);
+            }
+            double dist = sqrt(min_dist2);
+            for (int j=0; j<=_levels[i] && from[i] == -1; j++) {
+                if (dist <= extents[j]) from[i] = j;
+            }
+        }
+    }
+    return from;
+}
+
+/**
+ * Chooses the radius of the given points by evaluating their balls from the given levels up.
+ * A point whose chosen radius is already known to reach the threshold at some level stops there.
+ */
+template<IsPowZ P>
+void IncrementalClustering<P>::evaluate(std::vector<int> indexes, std::vector<int> from_levels) {
+    int n = _points.size();
+    int top = _radius_levels.size() - 1;
+    std::vector<int> label_levels(indexes.size(), -1);
+    std::vector<int> upper_levels(indexes.size());
+    for (size_t k=0; k<indexes.size(); k++) {
+        int level = _levels[indexes[k]];
+        upper_levels[k] = level >= 0 && level <= top ? level : top;
+    }
+
+    std::vector<tagged_point> centers;
+    std::vector<int> pending;
+    for (int j=0; j<=top && !indexes.empty(); j++) {
+        radius_level& level = _radius_levels[j];
+        centers.clear();
+        pending.clear();
+        for (size_t k=0; k<indexes.size(); k++) {
+            if (label_levels[k] != -1 || from_levels[k] > j) continue;
+            if (upper_levels[k] == j) {
+                _levels[indexes[k]] = j;
+                _r_approx[indexes[k]] = level.radius;
+                label_levels[k] = j;
+            } else {
+                pending.push_back(k);
+                centers.push_back(_points[indexes[k]]);
+                centers.back().hash = level.size_scheme->hash(centers.back());
+            }
+        }
+        if (pending.empty()) continue;
+
+        std::vector<int> sizes = eval_balls(centers, level.radius, Composable::Size, *level.size_scheme, level.sizes);
+        phase_timer timer(SelectionPhase);
+        for (size_t c=0; c<pending.size(); c++) {
+            int i = indexes[pending[c]];
+            if (sizes[c] >= threshold(level.radius)) {
+                _levels[i] = j;
+                _r_approx[i] = level.radius;
+                label_levels[pending[c]] = j;
+            } else if (sizes[c] == n) {
+                _levels[i] = -1;
+                _r_approx[i] = _pz.invpow(_facility_cost / (2 * _pz.pow(_beta) * n));
+                label_levels[pending[c]] = j;
+            }
+        }
+    }
+
+    for (int j=0; j<=top; j++) {
+        radius_level& level = _radius_levels[j];
+        centers.clear();
+        pending.clear();
+        for (size_t k=0; k<indexes.size(); k++) {
+            if (label_levels[k] != j) continue;
+            pending.push_back(indexes[k]);
+            centers.push_back(_points[indexes[k]]);
+            centers.back().hash = level.label_scheme->hash(centers.back());
+        }
+        if (pending.empty()) continue;
+
+        std::vector<ull> min_labels = eval_balls(centers, level.radius, Composable::MinLabelValue, *level.label_scheme, level.min_labels);
+        for (size_t c=0; c<pending.size(); c++) {
+            _min_labels[pending[c]] = min_labels[c];
+        }
+    }
+}
+
+/**
+ * Updates the nearest facility of every point: new points and points of closed or expired facilities
+ * search all facilities, the other points only the opened ones.
+ */
+template<IsPowZ P>
+void IncrementalClustering<P>::assign(const std::vector<int>& opened, const std::vector<int>& closed, size_t first_new) {
+    phase_timer timer(SelectionPhase);
+    std::vector<point> all_facilities, opened_facilities;
+    std::vector<int> all_indexes;
+    for (size_t i=0; i<_points.size(); i++) {
+        if (!_is_facility[i]) continue;
+        all_facilities.push_back(_points[i]);
+        all_indexes.push_back(i);
+    }
+    for (int i: opened) {
+        opened_facilities.push_back(_points[i]);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i=0; i<_points.size(); i++) {
+        if (i >= first_new || _nearest[i] < 0 || !_is_facility[_nearest[i]]) {
+            dist_pair nearest = min_dist(_points[i], all_facilities);
+            _nearest[i] = all_indexes[nearest.index];
+            _nearest_dist[i] = nearest.dist;
+        } else if (!opened_facilities.empty()) {
+            dist_pair nearest = min_dist(_points[i], opened_facilities);
+            if (nearest.dist < _nearest_dist[i]) {
+                _nearest[i] = opened[nearest.index];
+                _nearest_dist[i] = nearest.dist;
+            }
+        }
+    }
+
+    std::fill(_weights.begin(), _weights.end(), 0);
+    for (int f: _nearest) {
+        _weights[f]++;
+    }
+    INSTR_RECORD("incremental_clustering.opened", opened.size());
+    INSTR_RECORD("incremental_clustering.closed", closed.size());
+}
+
+template<IsPowZ P>
+void IncrementalClustering<P>::insert(const std::vector<tagged_point>& points) {
+    INSTR_TIMER("incremental_clustering.insert");
+    size_t first_new = _points.size();
+    for (const tagged_point& p: points) {
+        _points.push_back(p);
+        _points.back().label = randRange(0ULL, std::numeric_limits<ull>::max());
+        _draws.push_back(randDouble(0, 1));
+        for (int d=0; d<_dimension; d++) {
+            _min_coords[d] = std::min(_min_coords[d], p[d]);
+            _max_coords[d] = std::max(_max_coords[d], p[d]);
+        }
+    }
+    size_t n = _points.size();
+    _levels.resize(n, -1);
+    _r_approx.resize(n, 0);
+    _min_labels.resize(n, 0);
+    _is_facility.resize(n, false);
+    _nearest.resize(n, -1);
+    _nearest_dist.resize(n, 0);
+    _weights.resize(n, 0);
+
+    // Radius guesses from the first one at which n points can reach the threshold to the first one at which a single point does,
+    // or at which every ball contains all points (the radius is at least their diameter)
+    size_t prepended = 0;
+    if (_radius_levels.empty()) {
+        double r_guess = 1.0 / scale;
+        while (threshold(r_guess) > n) r_guess *= 2;
+        _radius_levels.push_back(make_level(r_guess));
+        prepended = 1;
+    } else {
+        while (_radius_levels.front().radius / 2 >= 1.0 / scale && threshold(_radius_levels.front().radius / 2) <= n) {
+            _radius_levels.push_front(make_level(_radius_levels.front().radius / 2));
+            prepended++;
+        }
+    }
+    size_t appended = _radius_levels.size();
+    double diameter = _min_coords.dist(_max_coords);
+    while (threshold(_radius_levels.back().radius) > 1 && _radius_levels.back().radius < diameter) {
+        _radius_levels.push_back(make_level(_radius_levels.back().radius * 2));
+    }
+    for (size_t j=0; j<_radius_levels.size(); j++) {
+        aggregate(_radius_levels[j], j < prepended || j >= appended ? 0 : first_new, n);
+    }
+    INSTR_RECORD("incremental_clustering.levels", _radius_levels.size());
+
+    // Balls of old points change only if they reach a new point, all of them change at new levels
+    std::vector<int> indexes, from_levels;
+    if (prepended > 0) {
+        for (size_t i=0; i<first_new; i++) {
+            if (_levels[i] >= 0) _levels[i] += prepended;
+            indexes.push_back(i);
+            from_levels.push_back(0);
+        }
+    } else {
+        std::vector<int> from = touched_levels(std::vector<tagged_point>(_points.begin() + first_new, _points.end()), first_new);
+        for (size_t i=0; i<first_new; i++) {
+            if (from[i] == -1) continue;
+            indexes.push_back(i);
+            from_levels.push_back(from[i]);
+        }
+    }
+    INSTR_RECORD("incremental_clustering.reevaluated", indexes.size());
+    for (size_t i=first_new; i<n; i++) {
+        indexes.push_back(i);
+        from_levels.push_back(0);
+    }
+    evaluate(indexes, from_levels);
+    update(indexes, first_new);
+}
+
+template<IsPowZ P>
+void IncrementalClustering<P>::expire(size_t count) {
+    INSTR_TIMER("incremental_clustering.expire");
+    assert(count < _points.size());
+    if (count == 0) return;
+    std::vector<tagged_point> expired(_points.begin(), _points.begin() + count);
+    for (radius_level& level: _radius_levels) {
+        remove(level, count);
+    }
+
+    _points.erase(_points.begin(), _points.begin() + count);
+    _draws.erase(_draws.begin(), _draws.begin() + count);
+    _levels.erase(_levels.begin(), _levels.begin() + count);
+    _r_approx.erase(_r_approx.begin(), _r_approx.begin() + count);
+    _min_labels.erase(_min_labels.begin(), _min_labels.begin() + count);
+    _is_facility.erase(_is_facility.begin(), _is_facility.begin() + count);
+    _nearest.erase(_nearest.begin(), _nearest.begin() + count);
+    _nearest_dist.erase(_nearest_dist.begin(), _nearest_dist.begin() + count);
+    _weights.erase(_weights.begin(), _weights.begin() + count);
+    for (int& f: _nearest) {
+        f -= count;
+    }
+
+    size_t n = _points.size();
+    for (radius_level& level: _radius_levels) {
+        if (level.sizes.size() + level.min_labels.size() <= 4 * n) continue;
+        level.sizes = BucketTable<int>();
+        level.min_labels = BucketTable<ull>();
+        level.label_queues.clear();
+        aggregate(level, 0, n);
+    }
+
+    // Sizes only decrease, so the balls that lost a point are evaluated again from their chosen radius up
+    std::vector<int> from = touched_levels(expired, n);
+    std::vector<int> indexes, from_levels;
+    for (size_t i=0; i<n; i++) {
+        if (from[i] == -1) continue;
+        indexes.push_back(i);
+        from_levels.push_back(from[i]);
+        _levels[i] = -1;
+    }
+    INSTR_RECORD("incremental_clustering.reevaluated", indexes.size());
+    evaluate(indexes, from_levels);
+    update(indexes, n);
+}
+
+/**
+ * Opens and closes facilities among the evaluated points, then updates the assignment.
+ */
+template<IsPowZ P>
+void IncrementalClustering<P>::update(const std::vector<int>& indexes, size_t first_new) {
+    std::vector<int> opened, closed;
+    for (int i: indexes) {
+        double open = std::min(1.0, _pz.pow(_tau) * _pz.pow(_r_approx[i]) / _facility_cost);
+        bool is_facility = _points[i].label == _min_labels[i] || _draws[i] < open;
+        if (is_facility && !_is_facility[i]) opened.push_back(i);
+        if (!is_facility && _is_facility[i]) closed.push_back(i);
+        _is_facility[i] = is_facility;
+    }
+    assign(opened, closed, first_new);
+}
+
+template<IsPowZ P>
+std::vector<int> IncrementalClustering<P>::facilities() const {
+    std::vector<int> result;
+    for (size_t i=0; i<_points.size(); i++) {
+        if (_is_facility[i]) result.push_back(i);
+    }
+    return result;
+}
+
+template<IsPowZ P>
+std::vector<std::pair<int, weighted_point>> IncrementalClustering<P>::coreset() const {
+    std::vector<std::pair<int, weighted_point>> result;
+    for (int i: facilities()) {
+        result.push_back({i, weighted_point(_points[i])});
+        result.back().second.weight = _weights[i];
+    }
+    return result;
+}
+
+template<IsPowZ P>
+std::vector<int> IncrementalClustering<P>::centers() const {
+    phase_timer timer(SelectionPhase);
+    std::vector<std::pair<int, weighted_point>> weighted_points = coreset();
+    sort_by_weight(weighted_points);
+    std::vector<weighted_point> coreset_points;
+    for (const auto& [_, p]: weighted_points) {
+        coreset_points.push_back(p);
+    }
+
+    double max_d = _min_coords.dist(_max_coords);
+    int max_pow2 = log2(_points.size()*_pz.pow(max_d) / _pz.pow(_min_d)) + 1;
+    return best_weak_coreset(weighted_points, _k, _mu, _min_d, max_pow2, _pz, [&](const std::vector<int>& result) {
+        std::vector<point> centers;
+        for (int i: result) centers.push_back(_points[i]);
+        return solution_cost(coreset_points, centers, 0, _pz);
+    });
+}
+
+template std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>&, const int, const double, const double, pow_z<1>);
+template std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>&, const int, const double, const double, pow_z<2>);
+template std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>&, const int, const double, const double, pow_z_real);
+
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z<1>, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z<2>, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z_real, const double);
+
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z<1>, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z<2>, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z_real, const double);
+
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z<1>, std::pair<double, double>, BucketTableCache<int>*, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z<2>, std::pair<double, double>, BucketTableCache<int>*, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<tagged_point>, const int, HashingSchemeChoice, pow_z_real, std::pair<double, double>, BucketTableCache<int>*, const double);
+
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z<1>, std::pair<double, double>, BucketTableCache<ll>*, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z<2>, std::pair<double, double>, BucketTableCache<ll>*, const double);
+template std::vector<int> compute_clusters_seq(int, std::vector<weighted_point>, const int, HashingSchemeChoice, pow_z_real, std::pair<double, double>, BucketTableCache<ll>*, const double);
+
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<1>, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<2>, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z_real, const double);
+
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<1>, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<2>, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z_real, const double);
+
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<1>, std::pair<double, double>, BucketTableCache<int>*, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<2>, std::pair<double, double>, BucketTableCache<int>*, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<tagged_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z_real, std::pair<double, double>, BucketTableCache<int>*, const double);
+
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<1>, std::pair<double, double>, BucketTableCache<ll>*, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z<2>, std::pair<double, double>, BucketTableCache<ll>*, const double);
+template std::vector<clustering_solution> compute_clusters_multi_k(int, const std::vector<weighted_point>&, const std::vector<int>&, HashingSchemeChoice, pow_z_real, std::pair<double, double>, BucketTableCache<ll>*, const double);
+
+template std::vector<std::pair<ll, weighted_point>> merge_reduce_coreset(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z<1>);
+template std::vector<std::pair<ll, weighted_point>> merge_reduce_coreset(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z<2>);
+template std::vector<std::pair<ll, weighted_point>> merge_reduce_coreset(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z_real);
+
+template std::vector<ll> compute_clusters_merge_reduce(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z<1>, double);
+template std::vector<ll> compute_clusters_merge_reduce(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z<2>, double);
+template std::vector<ll> compute_clusters_merge_reduce(int, std::function<bool(std::vector<weighted_point>&)>, int, HashingSchemeChoice, pow_z_real, double);
+
+template std::vector<int> compute_clusters_merge_reduce(int, const std::vector<weighted_point>&, int, HashingSchemeChoice, pow_z<1>, size_t, double);
+template std::vector<int> compute_clusters_merge_reduce(int, const std::vector<weighted_point>&, int, HashingSchemeChoice, pow_z<2>, size_t, double);
+template std::vector<int> compute_clusters_merge_reduce(int, const std::vector<weighted_point>&, int, HashingSchemeChoice, pow_z_real, size_t, double);
+
+template class IncrementalClustering<pow_z<1>>;
+template class IncrementalClustering<pow_z<2>>;
+template class IncrementalClustering<pow_z_real>;
@@ -1,18 +1,28 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "points.hpp"
 #include "hashing.hpp"
+#include "bucket_cache.hpp"
+#include "pow_z.hpp"
 
 /**
  * @brief Moves every point to a the nearest facility to construct a coreset of weighted points.
  *
  * See https://arxiv.org/pdf/2307.07848 Section 5.1
  *
+ * @tparam T The type of the points, weighted points move with their whole weight.
  * @param points The set of points.
  * @param approx_k_facilities Facilities to move 
  * @return The coreset of weighted points.
  */
-std::vector<weighted_point> group_centers(const std::vector<tagged_point>& points, const std::vector<tagged_point>& approx_k_facilities);
+template<IsPoint T>
+std::vector<weighted_point> group_centers(const std::vector<T>& points, const std::vector<tagged_point>& approx_k_facilities);
 
 /**
  * @brief Sequential algorithm for weak coresets.
@@ -23,9 +33,11 @@ std::vector<weighted_point> group_centers(const std::vector<tagged_point>& point
  * @param k How many clusters to create.
  * @param mu The approximation parameter for the number of clusters.
  * @param guess A guess that 2-approximates optimal solution cost for weak coresets.
+ * @param pz The cost exponent z.
  * @return Set of cluster centers as original indexes.
  */
-std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>& weighted_points, const int k, const double mu, const double guess);
+template<IsPowZ P>
+std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_point>>& weighted_points, const int k, const double mu, const double guess, P pz);
 
 /**
  * @brief Sequential algorithm for clustering.
@@ -35,12 +47,249 @@ std::vector<int> weak_coresets_seq(const std::vector<std::pair<int, weighted_poi
  *
  * See https://arxiv.org/pdf/2307.07848 Section 5
  *
+ * A weighted point of weight w counts as w points at the same position (see `compute_facilities`),
+ * which lets inputs with many repeated points be clustered without expanding them.
+ *
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
  * @param dim The dimension of the space.
  * @param points The set of points P.
  * @param k How many clusters to create.
  * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
  * @param mu The approximation parameter for the number of clusters.
  *           The algorithm returns up to (1+𝜇)k and the cost of the solution scales with respect to 1/𝜇.
  * @return Set of cluster centers as indexes into the set of points P.
  */
-std::vector<int> compute_clusters_seq(int dim, std::vector<tagged_point> points, int k, HashingSchemeChoice hs_choice, double mu=0.1);
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_clusters_seq(int dim, std::vector<T> points, int k, HashingSchemeChoice hs_choice, P pz, double mu=0.1);
+
+/**
+ * @brief Sequential algorithm for clustering with a known approximation of the aspect ratio,
+ *        for callers that cluster the same points several times (see `compute_clusters_seq`).
+ *
+ * @param aspect_ratio The approximate minimum and maximum distance, as given by `aspect_ratio_approx` for the points.
+ * @param cache The cache of ball sizes of the points, shared by the calls, or NULL for one of this call only.
+ *              Its entries are reused by calls drawing the same hashing scheme seed, i.e. with the same random seed.
+ */
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_clusters_seq(int dim, std::vector<T> points, int k, HashingSchemeChoice hs_choice, P pz, std::pair<double, double> aspect_ratio, BucketTableCache<ball_size_t<T>>* cache, double mu=0.1);
+
+/// Solution of `compute_clusters_multi_k` for one number of clusters.
+struct clustering_solution {
+    int k;
+    std::vector<int> centers; ///< Cluster centers as indexes into the set of points
+    double cost;              ///< Cost of the points for the centers
+};
+
+/**
+ * @brief Sequential algorithm for clustering for several numbers of clusters at once, e.g. to find the elbow of the cost.
+ *
+ * The aspect ratio is approximated once and the guesses of the optimal cost are swept once for all k:
+ * the facility costs are the guesses divided by the largest k and the facility set of each is shared by all k
+ * (the guesses of a smaller k are the same facility costs times k). Every k then takes its best facility cost
+ * as in `compute_clusters_seq`, and k with the same one share its coreset.
+ * For a single k, the result is the same as `compute_clusters_seq` with the same random seed.
+ *
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
+ * @param dim The dimension of the space.
+ * @param points The set of points P.
+ * @param ks The numbers of clusters to create.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
+ * @param mu The approximation parameter for the number of clusters (see `compute_clusters_seq`).
+ * @return The solution of each k, in the order of `ks`.
+ */
+template<IsPoint T, IsPowZ P>
+std::vector<clustering_solution> compute_clusters_multi_k(int dim, const std::vector<T>& points, const std::vector<int>& ks, HashingSchemeChoice hs_choice, P pz, double mu=0.1);
+
+/**
+ * @brief Sequential algorithm for clustering for several numbers of clusters with a known approximation of the aspect ratio
+ *        (see `compute_clusters_multi_k`).
+ *
+ * @param aspect_ratio The approximate minimum and maximum distance, as given by `aspect_ratio_approx` for the points.
+ * @param cache The cache of ball sizes of the points, shared by the calls, or NULL for one of this call only.
+ */
+template<IsPoint T, IsPowZ P>
+std::vector<clustering_solution> compute_clusters_multi_k(int dim, const std::vector<T>& points, const std::vector<int>& ks, HashingSchemeChoice hs_choice, P pz, std::pair<double, double> aspect_ratio, BucketTableCache<ball_size_t<T>>* cache, double mu=0.1);
+
+/**
+ * @brief Merge-and-reduce tree of weighted coresets of a stream of chunks of points (see `compute_clusters_merge_reduce`).
+ *
+ * Every point is moved with its whole weight, so the weights of the root coreset sum to the total weight of the input.
+ * Each leaf is reduced with a seed drawn in advance, so the result depends on the random seed but not on the number of threads.
+ *
+ * @param dim The dimension of the space.
+ * @param next_chunk Function replacing its argument by the next chunk of points, returns `false` at the end of the input.
+ * @param k How many clusters the coresets are for.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
+ * @return The root coreset: weighted points with their indexes in the order they were read.
+ */
+template<IsPowZ P>
+std::vector<std::pair<ll, weighted_point>> merge_reduce_coreset(
+    int dim,
+    std::function<bool(std::vector<weighted_point>&)> next_chunk,
+    int k,
+    HashingSchemeChoice hs_choice,
+    P pz
+);
+
+/**
+ * @brief Clustering of weighted points by a merge-and-reduce tree of coresets, for inputs too big for `compute_clusters_seq`.
+ *
+ * Chunks of points are reduced to weighted coresets as in `compute_clusters_seq` (up to one chunk per thread in parallel).
+ * Coresets are merged like digits of a binary counter: two coresets of the same level are merged and reduced again
+ * into one of the next level, so at most one coreset per level is kept in memory. The coresets left at the end
+ * are merged into the root, on which the sequential algorithm for weak coresets picks the centers
+ * (evaluating the cost on the root coreset).
+ *
+ * @param dim The dimension of the space.
+ * @param next_chunk Function replacing its argument by the next chunk of points, returns `false` at the end of the input.
+ * @param k How many clusters to create.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
+ * @param mu The approximation parameter for the number of clusters.
+ * @return Set of cluster centers as indexes of points in the order they were read.
+ */
+template<IsPowZ P>
+std::vector<ll> compute_clusters_merge_reduce(
+    int dim,
+    std::function<bool(std::vector<weighted_point>&)> next_chunk,
+    int k,
+    HashingSchemeChoice hs_choice,
+    P pz,
+    double mu=0.1
+);
+
+/**
+ * @brief Clustering of weighted points by a merge-and-reduce tree of coresets over chunks of a vector.
+ *
+ * @param dim The dimension of the space.
+ * @param points The set of weighted points P.
+ * @param k How many clusters to create.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
+ * @param chunk_size The number of points in the leaves of the tree.
+ * @param mu The approximation parameter for the number of clusters.
+ * @return Set of cluster centers as indexes into the set of points P.
+ */
+template<IsPowZ P>
+std::vector<int> compute_clusters_merge_reduce(int dim, const std::vector<weighted_point>& points, int k, HashingSchemeChoice hs_choice, P pz, size_t chunk_size, double mu=0.1);
+
+/**
+ * @brief Clustering of a set of points that grows by batches and whose oldest points expire,
+ *        without recomputing from scratch, e.g. the last W points of a stream.
+ *
+ * The facility cost is guessed once, as in `compute_clusters_seq`, for the initial set of points.
+ * Bucket tables of ball sizes and minimum labels are kept for every radius guess 2^j / scale
+ * at which some ball can reach its threshold (as in `compute_facilities_streaming`), up to the first one
+ * at least the diameter of the points, whose balls contain all points. Levels are added as the points spread.
+ * Inserted points are composed into the buckets they hash to. Balls are evaluated again only for the new points
+ * and for points closer to some new point than `HashingScheme::ball_extent` at their chosen radius,
+ * as no other ball contains a changed bucket. The chosen radius of a point can only decrease.
+ * A point opens a facility by a uniform draw fixed on insertion, so facilities of untouched points stay open.
+ * Points keep their nearest facility, which is updated only for opened and closed facilities,
+ * and the weighted coreset is read off the assignment for `weak_coresets_seq`.
+ *
+ * Expired points are removed from the ball sizes by `Composable::InvertibleComposable::remove`.
+ * Minimum labels are not invertible, but points expire in the order they were inserted, so each bucket keeps
+ * the increasing labels that can still become its minimum (those without a smaller label inserted after them),
+ * and a bucket whose minimum label expires takes the next one. Balls within `HashingScheme::ball_extent`
+ * of an expired point are evaluated again from their chosen radius up.
+ * Buckets left empty are dropped when a table has twice as many buckets as points.
+ *
+ * @tparam P The type of the cost exponent z.
+ */
+template<IsPowZ P>
+class IncrementalClustering {
+  private:
+    /// Hashing schemes and bucket tables of one radius guess.
+    struct radius_level {
+        double radius;
+        std::unique_ptr<HashingScheme<int>> size_scheme;
+        std::unique_ptr<HashingScheme<ull>> label_scheme;
+        BucketTable<int> sizes;
+        BucketTable<ull> min_labels;
+        std::unordered_map<ull, std::vector<ull>> label_queues; ///< Labels of each bucket that can still become its minimum, increasing
+        std::vector<ull> label_hashes; ///< Hash of each point in `label_scheme`
+    };
+
+    int _dimension;
+    int _k;
+    HashingSchemeChoice _hs_choice;
+    P _pz;
+    double _mu;
+    double _facility_cost;
+    double _beta;
+    double _tau;
+    double _min_d;
+    point _min_coords;
+    point _max_coords;
+
+    std::vector<tagged_point> _points;
+    std::vector<double> _draws;        ///< Uniform draw deciding whether the point opens a facility
+    std::vector<int> _levels;          ///< Index of the level of the chosen radius, -1 if the ball contains all points
+    std::vector<double> _r_approx;     ///< Chosen radius
+    std::vector<ull> _min_labels;      ///< Minimum label in the ball of the chosen radius
+    std::vector<char> _is_facility;
+    std::vector<int> _nearest;         ///< Nearest facility
+    std::vector<double> _nearest_dist; ///< Distance to the nearest facility
+    std::vector<int> _weights;         ///< Number of points whose nearest facility is the point
+    std::deque<radius_level> _radius_levels;
+
+    double threshold(double radius) const;
+    radius_level make_level(double radius) const;
+    void aggregate(radius_level& level, size_t begin, size_t end);
+    void remove(radius_level& level, size_t count);
+    std::vector<int> touched_levels(const std::vector<tagged_point>& changed, size_t count) const;
+    void evaluate(std::vector<int> indexes, std::vector<int> from_levels);
+    void update(const std::vector<int>& indexes, size_t first_new);
+    void assign(const std::vector<int>& opened, const std::vector<int>& closed, size_t first_new);
+
+  public:
+    /**
+     * @brief Clusters the initial set of points.
+     *
+     * @param dim The dimension of the space.
+     * @param points The initial set of points, must not be empty.
+     * @param k How many clusters to create.
+     * @param hs_choice The choice of hashing scheme to use.
+     * @param pz The cost exponent z.
+     * @param mu The approximation parameter for the number of clusters.
+     */
+    IncrementalClustering(int dim, const std::vector<tagged_point>& points, int k, HashingSchemeChoice hs_choice, P pz, double mu=0.1);
+
+    /**
+     * @brief Appends a batch of points, which get the next indexes.
+     * @param points The points to append.
+     */
+    void insert(const std::vector<tagged_point>& points);
+
+    /**
+     * @brief Removes the oldest points; the indexes of the others decrease by `count`.
+     * @param count How many points to remove, must be less than `size()`.
+     */
+    void expire(size_t count);
+
+    /// The number of points inserted and not expired.
+    size_t size() const { return _points.size(); }
+
+    /// The points inserted and not expired, in order of insertion (hashes and labels are internal).
+    const std::vector<tagged_point>& points() const { return _points; }
+
+    /// The facility cost guessed for the initial set of points.
+    double facility_cost() const { return _facility_cost; }
+
+    /// The current facilities as indexes of points.
+    std::vector<int> facilities() const;
+
+    /// The current weighted coreset: facilities with the number of points nearest to them.
+    std::vector<std::pair<int, weighted_point>> coreset() const;
+
+    /**
+     * @brief Runs the sequential algorithm for weak coresets on the current coreset
+     *        (evaluating the cost of guesses on the coreset).
+     * @return Set of cluster centers as indexes of points.
+     */
+    std::vector<int> centers() const;
+};
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <stdexcept>
+
+#include "compact_points.hpp"
+#include "timing.hpp"
+#include "tracing.hpp"
+
+/**
+ * @brief Quantizes coordinates uniformly between the minimum and maximum of each dimension.
+ *
+ * @tparam C The integer type of stored coordinates.
+ */
+template<typename C>
+static void quantize(int dim, const std::vector<tagged_point>& points, std::vector<double>& offset, std::vector<double>& step, std::vector<C>& stored) {
+    constexpr double levels = (double) std::numeric_limits<C>::max() - std::numeric_limits<C>::min();
+    constexpr double lowest = std::numeric_limits<C>::min();
+    for (int d=0; d<dim; d++) {
+        ll lo = std::numeric_limits<ll>::max(), hi = std::numeric_limits<ll>::min();
+        for (const point& p: points) {
+            lo = std::min(lo, p[d]);
+            hi = std::max(hi, p[d]);
+        }
+        if (points.empty()) lo = hi = 0;
+        step[d] = std::max(((double) hi - (double) lo) / levels, 1.0) / scale;
+        offset[d] = (double) lo / scale - lowest * step[d];
+    }
+
+    stored.resize(points.size() * dim);
+    #pragma omp parallel for
+    for (size_t i=0; i<points.size(); i++) {
+        for (int d=0; d<dim; d++) {
+            double level = round(((double) points[i][d] / scale - offset[d]) / step[d]);
+            level = std::clamp(level, (double) std::numeric_limits<C>::min(), (double) std::numeric_limits<C>::max());
+            stored[i*dim + d] = (C) level;
+        }
+    }
+}
+
+CompactPoints::CompactPoints(int dim, const std::vector<tagged_point>& points, CoordinateStorage storage)
+    : _dimension(dim), _size(points.size()), _storage(storage), _offset(dim, 0), _step(dim, 1.0 / scale) {
+    switch (storage) {
+        case Int64Storage:
+            _int64.resize(_size * dim);
+            for (size_t i=0; i<_size; i++) {
+                std::copy(points[i].coords.begin(), points[i].coords.end(), &_int64[i*dim]);
+            }
+            break;
+        case Float32Storage:
+            for (int d=0; d<dim; d++) {
+                ll lo = std::numeric_limits<ll>::max(), hi = std::numeric_limits<ll>::min();
+                for (const point& p: points) {
+                    lo = std::min(lo, p[d]);
+                    hi = std::max(hi, p[d]);
+                }
+                _offset[d] = points.empty() ? 0 : ((double) lo + (double) hi) / 2 / scale;
+                _step[d] = 1;
+            }
+            _float32.resize(_size * dim);
+            #pragma omp parallel for
+            for (size_t i=0; i<_size; i++) {
+                for (int d=0; d<dim; d++) {
+                    _float32[i*dim + d] = (float) ((double) points[i][d] / scale - _offset[d]);
+                }
+            }
+            break;
+        case Int32Storage:
+            quantize(dim, points, _offset, _step, _int32);
+            break;
+        case Int16Storage:
+            quantize(dim, points, _offset, _step, _int16);
+            break;
+        default:
+            throw std::invalid_argument("Unsupported coordinate storage");
+    }
+}
+
+size_t CompactPoints::bytes() const {
+    return visit([&](const auto* values) { return _size * _dimension * sizeof(*values); });
+}
+
+void CompactPoints::decode(size_t i, double* coords) const {
+    visit([&](const auto* values) {
+        for (int d=0; d<_dimension; d++) {
+            coords[d] = _offset[d] + _step[d] * values[i*_dimension + d];
+        }
+    });
+}
+
+std::vector<tagged_point> CompactPoints::decode() const {
+    std::vector<tagged_point> points(_size, tagged_point(_dimension));
+    decode_into(points);
+    return points;
+}
+
+void CompactPoints::decode_into(std::vector<tagged_point>& points) const {
+    #pragma omp parallel
+    {
+        std::vector<double> coords(_dimension);
+        #pragma omp for
+        for (size_t i=0; i<_size; i++) {
+            decode(i, coords.data());
+            for (int d=0; d<_dimension; d++) {
+                points[i][d] = llround(coords[d] * scale);
+            }
+        }
+    }
+}
+
+template<IsPowZ P>
+double solution_cost(const CompactPoints& points, const std::vector<point>& facilities, double facility_cost, P pz) {
+    phase_timer timer(CostPhase);
+    int dim = points.dimension();
+    double cost = facilities.size() * facility_cost;
+    std::vector<double> dist(points.size());
+    std::vector<double> facility_coords = scaled_coords(dim, facilities);
+
+    points.visit([&](const auto* values) {
+        #pragma omp parallel
+        {
+            TRACE_SCOPE("solution_cost");
+            std::vector<double> p(dim);
+            #pragma omp for nowait
+            for (size_t i=0; i<points.size(); i++) {
+                for (int d=0; d<dim; d++) {
+                    p[d] = points.offset(d) + points.step(d) * values[i*dim + d];
+                }
+                dist[i] = pz.pow(sqrt(min_dist_squared(dim, p.data(), facility_coords)));
+            }
+        }
+    });
+
+    for (double d: dist) {
+        cost += d;
+    }
+    return cost;
+}
+
+template double solution_cost(const CompactPoints&, const std::vector<point>&, double, pow_z<1>);
+template double solution_cost(const CompactPoints&, const std::vector<point>&, double, pow_z<2>);
+template double solution_cost(const CompactPoints&, const std::vector<point>&, double, pow_z_real);
+
+std::vector<tagged_point> load_points(int n, int dim, CoordinateStorage storage, std::istream& in) {
+    std::vector<tagged_point> points = load_points(n, dim, in);
+    if (storage == Int64Storage) return points;
+
+    phase_timer timer(LoadPhase);
+    CompactPoints(dim, points, storage).decode_into(points);
+    return points;
+}
+
+CoordinateStorage choose_coordinate_storage(std::string choice) {
+    if (choice == "int64")        return Int64Storage;
+    else if (choice == "float32") return Float32Storage;
+    else if (choice == "int32")   return Int32Storage;
+    else if (choice == "int16")   return Int16Storage;
+    else                          throw std::invalid_argument("Unsupported coordinate storage " + choice);
+}
+
+std::string coordinate_storage_name(CoordinateStorage storage) {
+    switch (storage) {
+        case Int64Storage:   return "int64";
+        case Float32Storage: return "float32";
+        case Int32Storage:   return "int32";
+        case Int16Storage:   return "int16";
+        default:             throw std::invalid_argument("Unsupported coordinate storage");
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+#include "points.hpp"
+#include "pow_z.hpp"
+
+/**
+ * @brief Represent a choice of coordinate storage.
+ * - Int64Storage keeps the scaled `ll` coordinates of `point`
+ * - Float32Storage stores single-precision offsets from the center of the bounding box
+ * - Int32Storage and Int16Storage quantize each dimension uniformly between its minimum and maximum
+ */
+enum CoordinateStorage {Int64Storage, Float32Storage, Int32Storage, Int16Storage};
+
+/**
+ * @brief Set of points stored in a compact coordinate type.
+ *
+ * The value of coordinate d of point i is `offset[d] + step[d]·stored[i·dim + d]`,
+ * where offset and step of each dimension are chosen when the points are stored.
+ *
+ * Only cost evaluation (`solution_cost`) reads the compact coordinates. Hashing, aggregation
+ * and ball evaluation run on `point`'s 64-bit coordinates, decoded by `decode`.
+ */
+class CompactPoints {
+  private:
+    int _dimension;
+    size_t _size;
+    CoordinateStorage _storage;
+    std::vector<double> _offset;
+    std::vector<double> _step;
+
+    std::vector<ll> _int64;
+    std::vector<float> _float32;
+    std::vector<int32_t> _int32;
+    std::vector<int16_t> _int16;
+
+  public:
+    /**
+     * @brief Stores a set of points.
+     *
+     * @param dim The dimension of the space.
+     * @param points The points to store.
+     * @param storage The coordinate storage to use.
+     */
+    CompactPoints(int dim, const std::vector<tagged_point>& points, CoordinateStorage storage);
+
+    int dimension() const { return _dimension; }
+    size_t size() const { return _size; }
+    CoordinateStorage storage() const { return _storage; }
+    double offset(int d) const { return _offset[d]; }
+    double step(int d) const { return _step[d]; }
+
+    /// Number of bytes used by the stored coordinates.
+    size_t bytes() const;
+
+    /**
+     * @brief Calls f with a pointer to the stored coordinates (of type ll, float, int32_t or int16_t).
+     */
+    template<typename F>
+    auto visit(F&& f) const {
+        switch (_storage) {
+            case Float32Storage: return f(_float32.data());
+            case Int32Storage:   return f(_int32.data());
+            case Int16Storage:   return f(_int16.data());
+            default:             return f(_int64.data());
+        }
+    }
+
+    /**
+     * @brief Decodes coordinates of a point.
+     * @param i The index of the point.
+     * @param coords Output array of `dim` coordinates (not multiplied by `scale`).
+     */
+    void decode(size_t i, double* coords) const;
+
+    /**
+     * @brief Decodes all points into the `ll` representation used by the algorithms.
+     */
+    std::vector<tagged_point> decode() const;
+
+    /**
+     * @brief Decodes all points in place of the coordinates of points of the same dimension and size.
+     */
+    void decode_into(std::vector<tagged_point>& points) const;
+};
+
+/**
+ * @brief Computes the cost of a solution directly on compactly stored points.
+ * @param points The set of points.
+ * @param facilities The built facilities.
+ * @param facility_cost Cost per one facility.
+ * @param pz The cost exponent z.
+ * @return The total cost of the solution.
+ */
+template<IsPowZ P>
+double solution_cost(const CompactPoints& points, const std::vector<point>& facilities, double facility_cost, P pz);
+
+/**
+ * @brief Loads a set of points from a stream, rounding their coordinates to the given storage.
+ *
+ * The returned points hold exactly the values representable in the storage,
+ * so algorithms see the same data as kernels running on `CompactPoints`.
+ * The points are still 64-bit: this does not reduce the memory of the solvers.
+ *
+ * @param n The number of points to load.
+ * @param dim The dimension of the space.
+ * @param storage The coordinate storage.
+ * @param in The stream to read from.
+ * @return A vector of loaded points.
+ */
+std::vector<tagged_point> load_points(int n, int dim, CoordinateStorage storage, std::istream& in = std::cin);
+
+/**
+ * @brief Converts coordinate storage choice from string (int64, float32, int32, int16) to enum.
+ */
+CoordinateStorage choose_coordinate_storage(std::string choice);
+
+/**
+ * @brief Converts coordinate storage choice from enum to string.
+ */
+std::string coordinate_storage_name(CoordinateStorage storage);
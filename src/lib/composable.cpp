@@ -2,5 +2,7 @@
 
 namespace Composable {
     __Size Size = __Size();
+    __WeightedSize WeightedSize = __WeightedSize();
     __MinLabel MinLabel = __MinLabel();
+    __MinLabelValue MinLabelValue = __MinLabelValue();
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
+
 #include "points.hpp"
 
 namespace Composable {
@@ -24,6 +27,16 @@ namespace Composable {
          */
         virtual T evaluate(const tagged_point& p) const = 0;
 
+        /**
+         * @brief Evaluates the function on a set with single weighted point,
+         *        as on the point itself unless the function depends on the weight.
+         * @param p The point iside the set.
+         * @return The result of the function - f({p}).
+         */
+        virtual T evaluate(const weighted_point& p) const {
+            return evaluate(static_cast<const tagged_point&>(p));
+        }
+
         /**
          * @brief Composes two function values.
          * @param val1 The first function value - f(S_1).
@@ -33,10 +46,27 @@ namespace Composable {
         virtual T compose(T val1, T val2) const = 0;
     };
 
+    /**
+     * @brief Base struct for composable function whose composition can be undone,
+     *        so that points can be removed from a set without evaluating it again.
+     *
+     * @tparam T The type of the result of composable function.
+     */
+    template<typename T>
+    struct InvertibleComposable : Composable<T> {
+        /**
+         * @brief Removes a subset from a function value.
+         * @param val The function value on a set - f(S).
+         * @param removed The function value on a subset - f(S_2), where S_2 ⊆ S.
+         * @return The result on the difference - f(S \ S_2).
+         */
+        virtual T remove(T val, T removed) const = 0;
+    };
+
     /**
      * @brief Size of a set of points as a composable function
      */
-    struct __Size : Composable<int> {
+    struct __Size : InvertibleComposable<int> {
         int empty_value = 0;
         int evaluate(const tagged_point& p) const override {
             return 1;
@@ -44,6 +74,30 @@ namespace Composable {
         int compose(int val1, int val2) const override {
             return val1 + val2;
         }
+        int remove(int val, int removed) const override {
+            return val - removed;
+        }
+    };
+
+    /**
+     * @brief Total weight of a set of points as a composable function,
+     *        which counts points without a weight once (see `weight_of`)
+     */
+    struct __WeightedSize : InvertibleComposable<ll> {
+        // Set in the base, which is what callers holding a Composable<ll>& see
+        __WeightedSize() { empty_value = 0; }
+        ll evaluate(const tagged_point& p) const override {
+            return weight_of(p);
+        }
+        ll evaluate(const weighted_point& p) const override {
+            return weight_of(p);
+        }
+        ll compose(ll val1, ll val2) const override {
+            return val1 + val2;
+        }
+        ll remove(ll val, ll removed) const override {
+            return val - removed;
+        }
     };
 
     /**
@@ -61,8 +115,27 @@ namespace Composable {
         }
     };
 
+    /**
+     * @brief Minimum label in a set of points as a composable function, by value
+     *        (for sets whose points do not stay in memory)
+     */
+    struct __MinLabelValue : Composable<ull> {
+        // Set in the base, which is what callers holding a Composable<ull>& see
+        __MinLabelValue() { empty_value = std::numeric_limits<ull>::max(); }
+        ull evaluate(const tagged_point& p) const override {
+            return p.label;
+        }
+        ull compose(ull val1, ull val2) const override {
+            return std::min(val1, val2);
+        }
+    };
+
     /// Singleton instance of the __Size composable function.
     extern __Size Size;
+    /// Singleton instance of the __WeightedSize composable function.
+    extern __WeightedSize WeightedSize;
     /// Singleton instance of the __MinLabel composable function.
     extern __MinLabel MinLabel;
+    /// Singleton instance of the __MinLabelValue composable function.
+    extern __MinLabelValue MinLabelValue;
 }
@@ -1,5 +1,5 @@
 // Experimental constants
-// - First for GridHashing, second for FaceHashing
-const double beta_mul[2] = {0.2, 0.05};
-const double tau_exp_mul[2] = {0.15, 0.1};
-const double small_gamma_exp_mul[2] = {0.5, 0.1};
+// - First for GridHashing, second for FaceHashing, third for LSHHashing, fourth for LatticeHashing
+const double beta_mul[4] = {0.2, 0.05, 0.2, 0.2};
+const double tau_exp_mul[4] = {0.15, 0.1, 0.15, 0.15};
+const double small_gamma_exp_mul[4] = {0.5, 0.1, 0.5, 0.5};
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+#include "dimension_reduction.hpp"
+#include "random.hpp"
+#include "instrumentation.hpp"
+#include "tracing.hpp"
+
+int jl_dimension(size_t n, double epsilon) {
+    return ceil(8 * log(std::max<size_t>(n, 2)) / (epsilon * epsilon));
+}
+
+double jl_distortion(size_t n, int target_dim) {
+    return sqrt(8 * log(std::max<size_t>(n, 2)) / target_dim);
+}
+
+template<IsPoint T>
+std::vector<tagged_point> jl_project(int dim, const std::vector<T>& points, int target_dim, double epsilon) {
+    INSTR_TIMER("jl_project");
+    int sparsity = std::clamp<int>(ceil(epsilon * target_dim), 1, target_dim);
+    int block = target_dim / sparsity;
+
+    // Row and sign of each nonzero of the projection matrix, `sparsity` per input coordinate
+    std::vector<int> rows(dim * sparsity);
+    std::vector<double> signs(dim * sparsity);
+    for (int j=0; j<dim; j++) {
+        for (int b=0; b<sparsity; b++) {
+            int last = b+1 < sparsity ? (b+1) * block : target_dim;
+            rows[j*sparsity + b] = randRange(b * block, last - 1);
+            signs[j*sparsity + b] = randBool(0.5) ? 1.0 : -1.0;
+        }
+    }
+
+    std::vector<double> center(dim);
+    for (int j=0; j<dim; j++) {
+        ll lo = std::numeric_limits<ll>::max(), hi = std::numeric_limits<ll>::min();
+        for (const point& p: points) {
+            lo = std::min(lo, p[j]);
+            hi = std::max(hi, p[j]);
+        }
+        center[j] = points.empty() ? 0 : ((double) lo + (double) hi) / 2;
+    }
+
+    double norm = 1 / sqrt(sparsity);
+    double bound = (double) std::numeric_limits<ll>::max();
+    std::vector<tagged_point> projected(points.size(), tagged_point(target_dim));
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("jl_project");
+        std::vector<double> out(target_dim);
+        #pragma omp for nowait
+        for (size_t i=0; i<points.size(); i++) {
+            std::fill(out.begin(), out.end(), 0);
+            for (int j=0; j<dim; j++) {
+                double x = ((double) points[i][j] - center[j]) * norm;
+                for (int b=0; b<sparsity; b++) {
+                    out[rows[j*sparsity + b]] += signs[j*sparsity + b] * x;
+                }
+            }
+            for (int r=0; r<target_dim; r++) {
+                projected[i][r] = (ll) std::clamp(out[r], -bound, bound);
+            }
+        }
+    }
+    return projected;
+}
+
+template std::vector<tagged_point> jl_project(int, const std::vector<tagged_point>&, int, double);
+template std::vector<tagged_point> jl_project(int, const std::vector<weighted_point>&, int, double);
+
+int jl_target_dimension(size_t n, double epsilon, int target_dim) {
+    if (target_dim > 0) return target_dim;
+    return epsilon > 0 ? jl_dimension(n, epsilon) : 0;
+}
+
+template<IsPoint T>
+std::vector<T> reduce_dimension(int& dim, const std::vector<T>& points, double epsilon, int target_dim) {
+    target_dim = jl_target_dimension(points.size(), epsilon, target_dim);
+    if (target_dim == 0) return points;
+    if (epsilon <= 0) epsilon = jl_distortion(points.size(), target_dim);
+    INSTR_RECORD("reduce_dimension.target_dim", target_dim);
+    if (target_dim >= dim) return points;
+
+    std::vector<tagged_point> projected = jl_project(dim, points, target_dim, epsilon);
+    dim = target_dim;
+    if constexpr (std::is_same_v<T, tagged_point>) {
+        return projected;
+    } else {
+        std::vector<T> result(points);
+        for (size_t i=0; i<points.size(); i++) {
+            result[i].coords = std::move(projected[i].coords);
+        }
+        return result;
+    }
+}
+
+template std::vector<tagged_point> reduce_dimension(int&, const std::vector<tagged_point>&, double, int);
+template std::vector<weighted_point> reduce_dimension(int&, const std::vector<weighted_point>&, double, int);
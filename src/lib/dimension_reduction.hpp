@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include "points.hpp"
+
+/**
+ * @brief Gives the dimension to which a Johnson–Lindenstrauss transform projects n points
+ *        so that all pairwise distances are preserved up to a factor 1±ε with high probability.
+ *
+ *     k = ⌈8 ln n / ε²⌉
+ *
+ * @param n The number of points.
+ * @param epsilon The allowed distortion ε ∈ (0, 1).
+ * @return The target dimension k.
+ */
+int jl_dimension(size_t n, double epsilon);
+
+/**
+ * @brief Gives the distortion ε for which `jl_dimension` projects n points to k dimensions, ε = √(8 ln n / k).
+ *
+ * @param n The number of points.
+ * @param target_dim The target dimension k.
+ * @return The distortion ε (possibly ≥ 1 for small k).
+ */
+double jl_distortion(size_t n, int target_dim);
+
+/**
+ * @brief Gives the dimension to which `reduce_dimension` projects n points.
+ *
+ * @param n The number of points.
+ * @param epsilon The allowed distortion ε, or 0 to project to `target_dim`.
+ * @param target_dim The dimension to project to, or 0 to take the JL dimension for ε.
+ * @return The target dimension, or 0 if the reduction is disabled (both are 0).
+ *         The projection is skipped if it is not below the dimension of the space.
+ */
+int jl_target_dimension(size_t n, double epsilon, int target_dim);
+
+/**
+ * @brief Projects points with a sparse Johnson–Lindenstrauss transform (Kane–Nelson).
+ *
+ * Every input coordinate is added with a random sign to s = ⌈εk⌉ random output coordinates
+ * (one in each of s blocks of rows) and the result is scaled by 1/√s, so projecting a point
+ * takes O(ds) instead of O(dk) time. Points are centered first, which does not change distances
+ * and keeps projected coordinates within the range of `ll`.
+ *
+ * @tparam T The type of the points.
+ * @param dim The dimension of the space.
+ * @param points The set of points.
+ * @param target_dim The dimension k of the projection.
+ * @param epsilon The allowed distortion ε ∈ (0, 1), determines the sparsity.
+ * @return The projected points (in the same order, with default tags).
+ */
+template<IsPoint T>
+std::vector<tagged_point> jl_project(int dim, const std::vector<T>& points, int target_dim, double epsilon);
+
+/**
+ * @brief Optional dimension reduction stage run before the hashing-based algorithms.
+ *
+ * If the target dimension (given, or the JL dimension for ε, see `jl_target_dimension`) is smaller than `dim`,
+ * projects the points and updates `dim`, otherwise skips the projection and returns the points unchanged,
+ * which callers can tell by `dim` and report.
+ * As ⌈8 ln n / ε²⌉ > 73 for n ≥ 10^4 and any ε < 1, inputs of lower dimension need an explicit target dimension.
+ * Indexes into the result are indexes into `points`,
+ * so solutions computed on the projection are evaluated on the original coordinates.
+ * Weights of weighted points are kept.
+ *
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
+ * @param dim The dimension of the space (replaced by the dimension of the result).
+ * @param points The set of points.
+ * @param epsilon The allowed distortion ε ∈ (0, 1), or 0 to take it from the target dimension (see `jl_distortion`).
+ * @param target_dim The dimension to project to, or 0 to take the JL dimension for ε. The reduction is disabled if both are 0.
+ * @return The points to run the algorithms on.
+ */
+template<IsPoint T>
+std::vector<T> reduce_dimension(int& dim, const std::vector<T>& points, double epsilon, int target_dim = 0);
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <utility>
+
+#include "duplicates.hpp"
+#include "cell_hash.hpp"
+#include "parallel_sort.hpp"
+#include "timing.hpp"
+#include "instrumentation.hpp"
+
+std::vector<int> unique_points::to_original(const std::vector<int>& indexes) const {
+    std::vector<int> result;
+    result.reserve(indexes.size());
+    for (int i: indexes) {
+        result.push_back(original_indexes[i]);
+    }
+    return result;
+}
+
+unique_points collapse_duplicates(int dim, const std::vector<tagged_point>& points) {
+    phase_timer timer(LoadPhase);
+    CellHash coords_hash(dim, KeyedCellHash);
+    std::vector<std::pair<ull, int>> hashes(points.size());
+    #pragma omp parallel for
+    for (size_t i=0; i<points.size(); i++) {
+        hashes[i] = {coords_hash([&](int d) { return (ull) points[i][d]; }), i};
+    }
+    parallel_sort(hashes);
+
+    // First copy and number of copies of each distinct point; within equal hashes indexes are increasing
+    std::vector<std::pair<int, int>> groups;
+    for (size_t begin=0, end; begin<hashes.size(); begin=end) {
+        size_t first_group = groups.size();
+        for (end=begin; end<hashes.size() && hashes[end].first == hashes[begin].first; end++) {
+            const tagged_point& p = points[hashes[end].second];
+            size_t g = first_group;
+            while (g < groups.size() && points[groups[g].first] != p) g++;
+            if (g == groups.size()) groups.push_back({hashes[end].second, 0});
+            groups[g].second++;
+        }
+    }
+    std::sort(groups.begin(), groups.end());
+
+    unique_points result;
+    result.points.reserve(groups.size());
+    result.original_indexes.reserve(groups.size());
+    for (auto [i, copies]: groups) {
+        result.points.push_back(weighted_point(points[i]));
+        result.points.back().weight = copies;
+        result.original_indexes.push_back(i);
+    }
+    INSTR_RECORD("collapse_duplicates.unique_points", result.points.size());
+    return result;
+}
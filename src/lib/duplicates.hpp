@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "points.hpp"
+
+/**
+ * @brief Set of distinct points with the number of copies of each, and a mapping back to the original set.
+ */
+struct unique_points {
+    std::vector<weighted_point> points; ///< Distinct points, weighted by the number of their copies
+    std::vector<int> original_indexes;  ///< Index of the first copy of each distinct point in the original set
+
+    /**
+     * @brief Maps indexes into the distinct points to indexes into the original set.
+     * @param indexes Indexes into `points`.
+     * @return Indexes of the first copies in the original set.
+     */
+    std::vector<int> to_original(const std::vector<int>& indexes) const;
+};
+
+/**
+ * @brief Collapses exact duplicates of a set of points into weighted points.
+ *
+ * Coordinate tuples are hashed in parallel and sorted by hash, points with equal hashes
+ * are compared coordinate by coordinate, so hash collisions never merge distinct points.
+ * Distinct points keep the order of their first copies.
+ *
+ * Inputs with many duplicates (e.g. quantized readings) become smaller, and their
+ * nearest neighbor distance is no longer 0, which would force every radius guess.
+ *
+ * @param dim The dimension of the space.
+ * @param points The set of points.
+ * @return The distinct points with their weights and original indexes.
+ */
+unique_points collapse_duplicates(int dim, const std::vector<tagged_point>& points);
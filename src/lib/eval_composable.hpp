@@ -1,7 +1,108 @@
+#pragma once
+
+#include <unordered_map>
 #include <vector>
 
 #include "points.hpp"
 #include "hashing.hpp"
+#include "parallel_sort.hpp"
+#include "timing.hpp"
+#include "instrumentation.hpp"
+#include "tracing.hpp"
+
+/**
+ * @brief Evaluates composable function on approximation of a ball A_P(p, r) for each point p of a set
+ *        from the results of the function on the buckets of a hashing scheme.
+ *
+ * @tparam T The type of the result of composable function.
+ * @tparam Point The type of the points (`tagged_point` or `weighted_point`).
+ * @param points The points p, with their hashes set by the hashing scheme.
+ * @param radius The radius r determining size of the balls.
+ * @param f The composable function to evaluate.
+ * @param hashing_scheme The hashing scheme defining the buckets.
+ * @param bucket_values The results of composable function on each bucket separately.
+ * @return The vector of results of f on each A_P(p, r).
+ */
+template<typename T, IsPoint Point>
+std::vector<T> eval_balls(
+    const std::vector<Point>& points,
+    double radius,
+    const Composable::Composable<T>& f,
+    const HashingScheme<T>& hashing_scheme,
+    const BucketTable<T>& bucket_values
+) {
+    std::vector<T> proximity_points(points.size(), f.empty_value);
+    {
+        phase_timer timer(EvalBallPhase);
+        // Queries grouped by bucket if the hashing scheme shares work among points of a bucket
+        std::vector<int> order(points.size());
+        std::vector<size_t> batch_starts;
+        if (hashing_scheme.batches_queries()) {
+            std::vector<std::pair<ull, int>> queries(points.size());
+            for (size_t i=0; i<points.size(); i++) {
+                queries[i] = {points[i].hash, i};
+            }
+            parallel_sort(queries);
+            for (size_t i=0; i<queries.size(); i++) {
+                order[i] = queries[i].second;
+                if (i == 0 || queries[i].first != queries[i-1].first)
+                    batch_starts.push_back(i);
+            }
+        } else {
+            for (size_t i=0; i<points.size(); i++) {
+                order[i] = i;
+                batch_starts.push_back(i);
+            }
+        }
+        batch_starts.push_back(points.size());
+        size_t batches = batch_starts.size() - 1;
+
+        std::vector<const tagged_point*> centers(points.size());
+        for (size_t i=0; i<points.size(); i++) {
+            centers[i] = &points[order[i]];
+        }
+        std::vector<T> results(points.size(), f.empty_value);
+
+        #pragma omp parallel
+        {
+            TRACE_SCOPE("eval_ball");
+            #pragma omp for nowait schedule(dynamic, 64)
+            for (size_t b=0; b<batches; b++) {
+                hashing_scheme.eval_ball_batch(
+                    &centers[batch_starts[b]], batch_starts[b+1] - batch_starts[b],
+                    radius, f, bucket_values, &results[batch_starts[b]]
+                );
+            }
+            #pragma omp for nowait
+            for (size_t i=0; i<points.size(); i++) {
+                proximity_points[order[i]] = results[i];
+            }
+        }
+    }
+
+    return proximity_points;
+}
+
+/**
+ * @brief Composes the results of a composable function on the points of each bucket.
+ *
+ * @param points The points, with their hashes set by the hashing scheme.
+ * @param f The composable function.
+ * @param bucket_values The table to compose the results into.
+ * @param cells The cell coordinates of the points, `cell_dim` per point (NULL to identify buckets by hash).
+ * @param cell_dim The dimension of the cells.
+ */
+template<typename T, IsPoint Point>
+void aggregate_buckets(const std::vector<Point>& points, const Composable::Composable<T>& f, BucketTable<T>& bucket_values, const ull* cells = NULL, int cell_dim = 0) {
+    phase_timer timer(AggregatePhase);
+    constexpr size_t prefetch_distance = 16;
+    for (size_t i=0; i<points.size(); i++) {
+        if (i + prefetch_distance < points.size())
+            bucket_values.prefetch(points[i + prefetch_distance].hash);
+        T& bucket_value = bucket_values.get_or_insert(points[i].hash, cells ? &cells[i * cell_dim] : NULL, f.empty_value);
+        bucket_value = f.compose(bucket_value, f.evaluate(points[i]));
+    }
+}
 
 /**
  * @brief Evaluates composable function on approximation of a ball A_P(p, r) for each point p∈P.
@@ -9,10 +110,13 @@
  *     B_P(p, r) ⊆ A_P(p, r) ⊆ B(p, 𝛽r)
  * 
  * where 𝛽=3𝚪 and 𝚪 is a parameter of the chosen hashing scheme.
+ *
+ * Buckets are identified as selected by the global `bucket_identity`.
  * 
  * See https://arxiv.org/pdf/2307.07848 Algorithm 1.
  *
  * @tparam T The type of the result of composable function.
+ * @tparam Point The type of the points (`tagged_point` or `weighted_point`).
  * @param dim The dimension of the space.
  * @param points The set of points P.
  * @param radius The radius r determining size of the balls.
@@ -20,33 +124,46 @@
  * @param hs_choice The choice of hashing scheme to use.
  * @return The vector of results of f on each A_P(p, r).
  */
-template<typename T>
+template<typename T, IsPoint Point>
 std::vector<T> eval_composable(
     int dim,
-    std::vector<tagged_point>& points,
+    std::vector<Point>& points,
     double radius,
     const Composable::Composable<T>& f,
     HashingSchemeChoice hs_choice
 ) {
+    INSTR_TIMER("eval_composable");
     std::unique_ptr<HashingScheme<T>> hashing_scheme = make_hashing_scheme<T>(hs_choice, dim, radius);
+    bool exact = bucket_identity == CellBucketIdentity;
+    int cell_dim = hashing_scheme->cell_dimension();
 
-    #pragma omp parallel for
-    for (tagged_point &p: points) {
-        p.hash = hashing_scheme->hash(p);
+    // Cell coordinates of the points, kept only when buckets are identified by cells
+    std::vector<ull> cells(exact ? points.size() * cell_dim : 0);
+    {
+        phase_timer timer(HashPhase);
+        #pragma omp parallel
+        {
+            TRACE_SCOPE("hash");
+            #pragma omp for nowait
+            for (size_t i=0; i<points.size(); i++) {
+                points[i].hash = exact ? hashing_scheme->hash(points[i], &cells[i * cell_dim]) : hashing_scheme->hash(points[i]);
+            }
+        }
     }
 
-    std::unordered_map<ull, T> bucket_values;
-    for (tagged_point &p: points) {
-        if (bucket_values.find(p.hash) == bucket_values.end())
-            bucket_values[p.hash] = f.empty_value;
-        bucket_values[p.hash] = f.compose(bucket_values[p.hash], f.evaluate(p));
+    BucketTable<T> bucket_values = exact ? BucketTable<T>(cell_dim, cells) : BucketTable<T>(points.size());
+    aggregate_buckets(points, f, bucket_values, exact ? cells.data() : NULL, cell_dim);
+    INSTR_COUNT("eval_composable.points", points.size());
+    INSTR_RECORD("eval_composable.buckets", bucket_values.size());
+#ifdef INSTRUMENT
+    std::unordered_map<ull, ull> bucket_sizes;
+    for (const tagged_point &p: points) {
+        bucket_sizes[p.hash]++;
     }
-
-    std::vector<T> proximity_points(points.size(), f.empty_value);
-    #pragma omp parallel for
-    for (int point_i=0; point_i<(int) points.size(); point_i++) {
-        proximity_points[point_i] = hashing_scheme->eval_ball(points[point_i], radius, f, bucket_values);
+    for (auto [_, size]: bucket_sizes) {
+        INSTR_RECORD("eval_composable.bucket_size", size);
     }
+#endif
 
-    return proximity_points;
+    return eval_balls(points, radius, f, *hashing_scheme, bucket_values);
 }
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <limits>
+#include <memory>
 
 #include "constants.hpp"
 #include "types.hpp"
@@ -8,11 +10,28 @@
 #include "eval_composable.hpp"
 #include "facility_set.hpp"
 #include "pow_z.hpp"
+#include "timing.hpp"
+#include "instrumentation.hpp"
 
-std::vector<int> compute_facilities(int dim, std::vector<tagged_point> points, double facility_cost, HashingSchemeChoice hs_choice) {
+/// Size of a set of points as a composable function, counting weighted points by their weight.
+template<IsPoint T>
+static const auto& size_composable() {
+    if constexpr (std::is_same_v<T, weighted_point>) return Composable::WeightedSize;
+    else return Composable::Size;
+}
+
+template<IsPoint T, IsPowZ P>
+static std::vector<int> compute_facilities(int dim, std::vector<T>& points, double facility_cost, HashingSchemeChoice hs_choice, P pz, BucketTableCache<ball_size_t<T>>* cache, ull scheme_seed) {
+    INSTR_TIMER("compute_facilities");
+    if (bucket_identity != HashBucketIdentity) cache = NULL;
     for (auto &p: points) {
         p.label = randRange(0ULL, std::numeric_limits<ull>::max());
     }
+    const auto& size = size_composable<T>();
+    decltype(size.empty_value) total_weight = 0;
+    for (const auto &p: points) {
+        total_weight += weight_of(p);
+    }
  
     std::vector<double> r_approx(points.size(), 0);
     std::vector<const tagged_point*> min_labels(points.size(), NULL);
@@ -20,30 +39,197 @@ std::vector<int> compute_facilities(int dim, std::vector<tagged_point> points, d
     double r_guess = 1.0 / scale;
     double beta = beta_mul[hs_choice] * 3.0 * get_gamma(hs_choice, dim);
     double alpha = 3 * beta * beta;
-    double tau = pow(alpha * beta, tau_exp_mul[hs_choice]*Z);
+    double tau = pow(alpha * beta, tau_exp_mul[hs_choice]*pz.z());
+    ull rounds = 0;
     while (find(r_approx.begin(), r_approx.end(), 0) != r_approx.end()) {
-        std::vector<int> approx_ball_sizes = eval_composable(dim, points, r_guess, Composable::Size, hs_choice);
-        std::vector<const tagged_point*> guess_min_labels = eval_composable(dim, points, r_guess, Composable::MinLabel, hs_choice);
+        std::vector<ball_size_t<T>> approx_ball_sizes;
+        std::vector<const tagged_point*> guess_min_labels;
+        if (cache == NULL) {
+            approx_ball_sizes = eval_composable(dim, points, r_guess, size, hs_choice);
+            guess_min_labels = eval_composable(dim, points, r_guess, Composable::MinLabel, hs_choice);
+        } else {
+            approx_ball_sizes = cached_ball_sizes(dim, points, r_guess, size, hs_choice, scheme_seed, *cache)->ball_sizes;
+            // The scheme hashes as the cached one, only the labels have to be aggregated
+            auto label_scheme = make_hashing_scheme<const tagged_point*>(hs_choice, dim, r_guess, scheme_seed);
+            BucketTable<const tagged_point*> label_values(points.size());
+            aggregate_buckets(points, Composable::MinLabel, label_values);
+            guess_min_labels = eval_balls(points, r_guess, Composable::MinLabel, *label_scheme, label_values);
+        }
 
+        phase_timer timer(SelectionPhase);
         #pragma omp parallel for
         for (size_t i=0; i<points.size(); i++) {
             if (r_approx[i] != 0) continue;
-            if (approx_ball_sizes[i] >= facility_cost / (2 * POWZ(beta) * POWZ(r_guess))) {
+            if (approx_ball_sizes[i] >= facility_cost / (2 * pz.pow(beta) * pz.pow(r_guess))) {
                 r_approx[i] = r_guess;
                 min_labels[i] = guess_min_labels[i];
-            } else if (approx_ball_sizes[i] == (int) points.size()) {
-                r_approx[i] = INVPOWZ(facility_cost / (2 * POWZ(beta) * points.size()));
+            } else if (approx_ball_sizes[i] == total_weight) {
+                r_approx[i] = pz.invpow(facility_cost / (2 * pz.pow(beta) * total_weight));
                 min_labels[i] = guess_min_labels[i];
             }
         }
 
         r_guess *= 2;
+        rounds++;
     }
+    INSTR_RECORD("compute_facilities.r_guess_rounds", rounds);
 
+    phase_timer timer(SelectionPhase);
     std::vector<int> results;
     for (int i=0; i<(int) points.size(); i++) {
-        if (&points[i] == min_labels[i] || randBool(POWZ(tau) * POWZ(r_approx[i]) / facility_cost))
+        double open = pz.pow(tau) * pz.pow(r_approx[i]) / facility_cost;
+        // A point of weight w opens a facility if any of the w points it represents would
+        int weight = weight_of(points[i]);
+        if (weight != 1) open = 1 - pow(1 - std::min(open, 1.0), weight);
+        if (&points[i] == min_labels[i] || randBool(open))
             results.push_back(i);
     }
+    INSTR_RECORD("compute_facilities.facilities", results.size());
     return results;
 }
+
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_facilities(int dim, std::vector<T> points, double facility_cost, HashingSchemeChoice hs_choice, P pz) {
+    return compute_facilities(dim, points, facility_cost, hs_choice, pz, (BucketTableCache<ball_size_t<T>>*) NULL, 0);
+}
+
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_facilities(int dim, std::vector<T> points, double facility_cost, HashingSchemeChoice hs_choice, P pz, BucketTableCache<ball_size_t<T>>& cache, ull scheme_seed) {
+    return compute_facilities(dim, points, facility_cost, hs_choice, pz, &cache, scheme_seed);
+}
+
+/// Label of the i-th point of a stream, the same in every pass over it (SplitMix64 of the index).
+static ull stream_label(ull label_seed, size_t i) {
+    ull x = label_seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+template<typename T>
+static void hash_chunk(std::vector<tagged_point>& chunk, const HashingScheme<T>& hashing_scheme) {
+    phase_timer timer(HashPhase);
+    #pragma omp parallel for
+    for (size_t i=0; i<chunk.size(); i++) {
+        chunk[i].hash = hashing_scheme.hash(chunk[i]);
+    }
+}
+
+template<typename T>
+static void aggregate_chunk(std::vector<tagged_point>& chunk, const HashingScheme<T>& hashing_scheme, BucketTable<T>& bucket_values, const Composable::Composable<T>& f) {
+    hash_chunk(chunk, hashing_scheme);
+    phase_timer timer(AggregatePhase);
+    for (const tagged_point& p: chunk) {
+        T& bucket_value = bucket_values.get_or_insert(p.hash, NULL, f.empty_value);
+        bucket_value = f.compose(bucket_value, f.evaluate(p));
+    }
+}
+
+template<IsPowZ P>
+std::vector<int> compute_facilities_streaming(ChunkedPointReader& reader, double facility_cost, HashingSchemeChoice hs_choice, P pz) {
+    INSTR_TIMER("compute_facilities_streaming");
+    int dim = reader.dimension();
+    size_t n = reader.size();
+    ull label_seed = randRange(0ULL, std::numeric_limits<ull>::max());
+
+    double beta = beta_mul[hs_choice] * 3.0 * get_gamma(hs_choice, dim);
+    double alpha = 3 * beta * beta;
+    double tau = pow(alpha * beta, tau_exp_mul[hs_choice]*pz.z());
+    auto threshold = [&](double r) { return facility_cost / (2 * pz.pow(beta) * pz.pow(r)); };
+
+    // Below the first guess no ball is big enough, at the last one every ball is
+    std::vector<double> radii;
+    double r_guess = 1.0 / scale;
+    while (threshold(r_guess) > n) r_guess *= 2;
+    do {
+        radii.push_back(r_guess);
+        r_guess *= 2;
+    } while (threshold(radii.back()) > 1);
+    INSTR_RECORD("compute_facilities.r_guess_rounds", radii.size());
+
+    std::vector<std::unique_ptr<HashingScheme<int>>> size_schemes;
+    std::vector<std::unique_ptr<HashingScheme<ull>>> label_schemes;
+    std::vector<BucketTable<int>> size_tables(radii.size());
+    std::vector<BucketTable<ull>> label_tables(radii.size());
+    for (double r: radii) {
+        size_schemes.push_back(make_hashing_scheme<int>(hs_choice, dim, r));
+        label_schemes.push_back(make_hashing_scheme<ull>(hs_choice, dim, r));
+    }
+
+    std::vector<tagged_point> chunk;
+    reader.rewind();
+    while (reader.next(chunk)) {
+        size_t offset = reader.position() - chunk.size();
+        for (size_t i=0; i<chunk.size(); i++) {
+            chunk[i].label = stream_label(label_seed, offset + i);
+        }
+        for (size_t j=0; j<radii.size(); j++) {
+            aggregate_chunk(chunk, *size_schemes[j], size_tables[j], Composable::Size);
+            aggregate_chunk(chunk, *label_schemes[j], label_tables[j], Composable::MinLabelValue);
+        }
+    }
+#ifdef INSTRUMENT
+    for (size_t j=0; j<radii.size(); j++) {
+        INSTR_RECORD("compute_facilities_streaming.buckets", size_tables[j].size() + label_tables[j].size());
+    }
+#endif
+
+    std::vector<int> results;
+    reader.rewind();
+    while (reader.next(chunk)) {
+        size_t offset = reader.position() - chunk.size();
+        for (size_t i=0; i<chunk.size(); i++) {
+            chunk[i].label = stream_label(label_seed, offset + i);
+        }
+
+        std::vector<double> r_approx(chunk.size(), 0);
+        std::vector<ull> min_labels(chunk.size());
+        for (size_t j=0; j<radii.size() && find(r_approx.begin(), r_approx.end(), 0) != r_approx.end(); j++) {
+            hash_chunk(chunk, *size_schemes[j]);
+            std::vector<int> approx_ball_sizes = eval_balls(chunk, radii[j], Composable::Size, *size_schemes[j], size_tables[j]);
+            hash_chunk(chunk, *label_schemes[j]);
+            std::vector<ull> guess_min_labels = eval_balls(chunk, radii[j], Composable::MinLabelValue, *label_schemes[j], label_tables[j]);
+
+            phase_timer timer(SelectionPhase);
+            #pragma omp parallel for
+            for (size_t i=0; i<chunk.size(); i++) {
+                if (r_approx[i] != 0) continue;
+                if (approx_ball_sizes[i] >= threshold(radii[j])) {
+                    r_approx[i] = radii[j];
+                    min_labels[i] = guess_min_labels[i];
+                } else if (approx_ball_sizes[i] == (int) n) {
+                    r_approx[i] = pz.invpow(facility_cost / (2 * pz.pow(beta) * n));
+                    min_labels[i] = guess_min_labels[i];
+                }
+            }
+        }
+
+        phase_timer timer(SelectionPhase);
+        for (size_t i=0; i<chunk.size(); i++) {
+            if (chunk[i].label == min_labels[i] || randBool(pz.pow(tau) * pz.pow(r_approx[i]) / facility_cost))
+                results.push_back(offset + i);
+        }
+    }
+    INSTR_RECORD("compute_facilities.facilities", results.size());
+    return results;
+}
+
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z<1>);
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z<2>);
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z_real);
+
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z<1>);
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z<2>);
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z_real);
+
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z<1>, BucketTableCache<int>&, ull);
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z<2>, BucketTableCache<int>&, ull);
+template std::vector<int> compute_facilities(int, std::vector<tagged_point>, double, HashingSchemeChoice, pow_z_real, BucketTableCache<int>&, ull);
+
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z<1>, BucketTableCache<ll>&, ull);
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z<2>, BucketTableCache<ll>&, ull);
+template std::vector<int> compute_facilities(int, std::vector<weighted_point>, double, HashingSchemeChoice, pow_z_real, BucketTableCache<ll>&, ull);
+
+template std::vector<int> compute_facilities_streaming(ChunkedPointReader&, double, HashingSchemeChoice, pow_z<1>);
+template std::vector<int> compute_facilities_streaming(ChunkedPointReader&, double, HashingSchemeChoice, pow_z<2>);
+template std::vector<int> compute_facilities_streaming(ChunkedPointReader&, double, HashingSchemeChoice, pow_z_real);
@@ -1,14 +1,59 @@
+#pragma once
+
 #include "hashing.hpp"
+#include "bucket_cache.hpp"
+#include "pow_z.hpp"
 
 /**
  * @brief Computes set of facilities to open for some set of points P.
  *
  * See https://arxiv.org/pdf/2307.07848 Algorithm 2.
  *
+ * A weighted point of weight w is treated as w points at the same position: ball sizes
+ * sum weights and the point opens a facility with probability 1-(1-q)^w instead of q.
+ *
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
  * @param dim The dimension of the space.
  * @param points The set of points P.
  * @param facility_cost The cost per one opened facility.
  * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
+ * @return Set of facilities as indexes into set of points P.
+ */
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_facilities(int dim, std::vector<T> points, double facility_cost, HashingSchemeChoice hs_choice, P pz);
+
+/**
+ * @brief Computes set of facilities to open for some set of points P, taking the ball sizes of each radius guess
+ *        from a cache shared by calls on the same points (e.g. for several facility costs).
+ *
+ * The hashing scheme of each radius is created from `scheme_seed`, and minimum labels are evaluated
+ * with the same scheme (reusing the hashes), as labels differ between calls.
+ * With CellBucketIdentity the cache is not used.
+ *
+ * @param cache The cache of ball sizes of the points.
+ * @param scheme_seed The seed of the hashing schemes.
+ * @see compute_facilities
+ */
+template<IsPoint T, IsPowZ P>
+std::vector<int> compute_facilities(int dim, std::vector<T> points, double facility_cost, HashingSchemeChoice hs_choice, P pz, BucketTableCache<ball_size_t<T>>& cache, ull scheme_seed);
+
+/**
+ * @brief Computes set of facilities to open for a set of points P read from a stream in two passes,
+ *        for sets that do not fit in memory.
+ *
+ * The first pass aggregates each chunk of points into the buckets of every radius guess 2^j / scale
+ * at which some point can reach its threshold (from n points down to 1 point). The second pass
+ * evaluates balls and selects facilities chunk by chunk, so memory is bounded by the number
+ * of occupied buckets over all guesses and the chunk size, but not by n.
+ * Labels are derived from the indexes of points, so both passes see the same labels.
+ * Buckets are always identified by hashes, as packing cells needs all of them in advance.
+ *
+ * @param reader The reader of the set of points P.
+ * @param facility_cost The cost per one opened facility.
+ * @param hs_choice The choice of hashing scheme to use.
+ * @param pz The cost exponent z.
  * @return Set of facilities as indexes into set of points P.
  */
-std::vector<int> compute_facilities(int dim, std::vector<tagged_point> points, double facility_cost, HashingSchemeChoice hs_choice);
+template<IsPowZ P>
+std::vector<int> compute_facilities_streaming(ChunkedPointReader& reader, double facility_cost, HashingSchemeChoice hs_choice, P pz);
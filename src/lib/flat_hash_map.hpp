@@ -0,0 +1,131 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+/**
+ * @brief Open-addressing hash table from 64-bit keys to values of type T.
+ *
+ * Uses linear probing in a power of two capacity with keys, values and occupancy
+ * stored in separate arrays, so probing touches only the (densely packed) keys.
+ * Load factor is kept at most 1/2. Elements cannot be removed.
+ *
+ * @tparam T The type of the values.
+ */
+template<typename T>
+class FlatHashMap {
+  private:
+    std::vector<ull> _keys;
+    std::vector<T> _values;
+    std::vector<uint8_t> _used;
+    size_t _size = 0;
+    int _shift = 64;
+
+    /// Fibonacci hashing: the multiplication spreads structured keys, the top bits give the slot.
+    size_t inline slot_of(ull key) const {
+        return (key * 0x9E3779B97F4A7C15ULL) >> _shift;
+    }
+
+    size_t inline mask() const {
+        return _keys.size() - 1;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<ull> keys(capacity);
+        std::vector<T> values(capacity);
+        std::vector<uint8_t> used(capacity, 0);
+        std::swap(keys, _keys);
+        std::swap(values, _values);
+        std::swap(used, _used);
+        _shift = 64 - std::countr_zero(capacity);
+
+        for (size_t i=0; i<keys.size(); i++) {
+            if (!used[i]) continue;
+            size_t slot = slot_of(keys[i]);
+            while (_used[slot]) slot = (slot + 1) & mask();
+            _used[slot] = 1;
+            _keys[slot] = keys[i];
+            _values[slot] = values[i];
+        }
+    }
+
+  public:
+    /**
+     * @brief Constructs an empty table.
+     * @param expected_size The number of elements to allocate space for.
+     */
+    FlatHashMap(size_t expected_size = 0) {
+        rehash(std::bit_ceil(std::max<size_t>(2 * expected_size, 16)));
+    }
+
+    size_t size() const { return _size; }
+
+    /// The memory taken by the table, in bytes.
+    size_t bytes() const { return _keys.capacity() * sizeof(ull) + _values.capacity() * sizeof(T) + _used.capacity(); }
+
+    /**
+     * @brief Gets the value stored under a key, inserting a given value if the key is missing.
+     * @param key The key.
+     * @param default_value The value to insert if the key is missing.
+     * @return Reference to the stored value (valid until the next insertion).
+     */
+    T& get_or_insert(ull key, const T& default_value) {
+        size_t slot = slot_of(key);
+        while (_used[slot]) {
+            if (_keys[slot] == key) return _values[slot];
+            slot = (slot + 1) & mask();
+        }
+        if (2 * (_size + 1) > _keys.size()) {
+            rehash(2 * _keys.size());
+            return get_or_insert(key, default_value);
+        }
+        _size++;
+        _used[slot] = 1;
+        _keys[slot] = key;
+        _values[slot] = default_value;
+        return _values[slot];
+    }
+
+    /**
+     * @brief Finds the value stored under a key.
+     * @param key The key.
+     * @return Pointer to the value or NULL if the key is missing.
+     */
+    const T* find(ull key) const {
+        size_t slot = slot_of(key);
+        while (_used[slot]) {
+            if (_keys[slot] == key) return &_values[slot];
+            slot = (slot + 1) & mask();
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Hints that a key will be looked up soon.
+     * @param key The key.
+     */
+    void prefetch(ull key) const {
+        size_t slot = slot_of(key);
+        __builtin_prefetch(&_used[slot]);
+        __builtin_prefetch(&_keys[slot]);
+        __builtin_prefetch(&_values[slot]);
+    }
+
+    /**
+     * @brief Finds values stored under several keys, overlapping their memory accesses.
+     * @param keys The keys.
+     * @param count The number of keys.
+     * @param values Output array of `count` pointers to the values (NULL for missing keys).
+     */
+    void find_batch(const ull* keys, size_t count, const T** values) const {
+        for (size_t i=0; i<count; i++) {
+            prefetch(keys[i]);
+        }
+        for (size_t i=0; i<count; i++) {
+            values[i] = find(keys[i]);
+        }
+    }
+};
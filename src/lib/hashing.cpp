@@ -2,10 +2,16 @@
 #include "points.hpp"
 #include "hashing.hpp"
 
+BucketIdentity bucket_identity = HashBucketIdentity;
+LSHParameters lsh_parameters;
+size_t bucket_cache_budget = 512 << 20;
+
 double get_gamma(const HashingSchemeChoice hs_choice, int dimension) {
     switch (hs_choice) {
         case GridHashingScheme: return GridHashing<point>::Gamma(dimension);
         case FaceHashingScheme: return FaceHashing<point>::Gamma(dimension);
+        case LSHHashingScheme:  return LSHHashing<point>::Gamma(dimension, lsh_parameters.projections);
+        case LatticeHashingScheme: return LatticeHashing<point>::Gamma(dimension);
         default: throw std::invalid_argument("Unsupported hashing scheme");
     }
 }
@@ -13,5 +19,7 @@ double get_gamma(const HashingSchemeChoice hs_choice, int dimension) {
 HashingSchemeChoice choose_hashing_scheme(std::string choice) {
     if (choice == "face_hashing")      return FaceHashingScheme;
     else if (choice == "grid_hashing") return GridHashingScheme;
+    else if (choice == "lsh_hashing")  return LSHHashingScheme;
+    else if (choice == "lattice_hashing") return LatticeHashingScheme;
     else                               invalid_usage_solver();
 }
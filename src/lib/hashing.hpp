@@ -1,9 +1,12 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <limits>
 #include <memory>
 #include <queue>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -12,6 +15,9 @@
 #include "points.hpp"
 #include "random.hpp"
 #include "composable.hpp"
+#include "bucket_table.hpp"
+#include "cell_hash.hpp"
+#include "instrumentation.hpp"
 
 /**
  * @brief Base class for consistent geometric hashing scheme implementations.
@@ -24,6 +30,15 @@ class HashingScheme {
     ull inline normalize_coord(const point& p, int i) const {
         return (ull) p.coords[i] - std::numeric_limits<ll>::min();
     }
+
+    /// Draws uniformly random offsets of coordinates, which randomly shift the cells.
+    static std::vector<ull> random_offsets(int dim) {
+        std::vector<ull> offsets(dim);
+        for (int i=0; i<dim; i++) {
+            offsets[i] = randRange((ull) 0, std::numeric_limits<ull>::max());
+        }
+        return offsets;
+    }
   public:
     virtual ~HashingScheme() = default;
 
@@ -35,6 +50,20 @@ class HashingScheme {
      */
     virtual ull hash(const point& p) const = 0;
 
+    /**
+     * @brief For a given point, gives the integer coordinates of its bucket's cell and the hash of the bucket.
+     *
+     * @param point The point to hash.
+     * @param cell Output array of d cell coordinates.
+     * @return The hash value of the bucket.
+     */
+    virtual ull hash(const point& p, ull* cell) const = 0;
+
+    /**
+     * @brief Gives the number of coordinates identifying a cell (d for cells of the space itself).
+     */
+    virtual int cell_dimension() const = 0;
+
     /**
      * @brief Evaluates a composable function f on approximation of a ball A_P(p, r).
      *
@@ -50,8 +79,48 @@ class HashingScheme {
         const tagged_point& center,
         const double radius,
         const Composable::Composable<T>& f,
-        const std::unordered_map<ull, T>& bucket_values
+        const BucketTable<T>& bucket_values
     ) const = 0;
+
+    /**
+     * @brief Gives a radius R such that A_P(p, r) ⊆ B(p, R) for every p, so that a bucket
+     *        can change the result of `eval_ball` only for centers closer than R to its points.
+     *        The default is infinity, which holds for any scheme.
+     *
+     * @param radius The radius r determining size of the approximated balls. Must be ≤ `radius` used in construction.
+     * @return The radius R (not multiplied by `scale`).
+     */
+    virtual double ball_extent(double radius) const { return std::numeric_limits<double>::infinity(); }
+
+    /**
+     * @brief Whether `eval_ball_batch` shares work among the points of a batch,
+     *        so that it pays off to group queries by bucket.
+     */
+    virtual bool batches_queries() const { return false; }
+
+    /**
+     * @brief Evaluates a composable function f on approximations of balls around a batch of points
+     *        with the same hash. The default evaluates each ball separately by `eval_ball`.
+     *
+     * @param centers The centers of the balls.
+     * @param count The number of points in the batch.
+     * @param radius The radius r determining size of the approximated balls. Must be ≤ `radius` used in construction.
+     * @param f The composable function to evaluate.
+     * @param bucket_values The results of composable function on each bucket separately.
+     * @param results Output array of `count` results of f on each A_P(p, r).
+     */
+    virtual void eval_ball_batch(
+        const tagged_point* const* centers,
+        size_t count,
+        const double radius,
+        const Composable::Composable<T>& f,
+        const BucketTable<T>& bucket_values,
+        T* results
+    ) const {
+        for (size_t k=0; k<count; k++) {
+            results[k] = eval_ball(*centers[k], radius, f, bucket_values);
+        }
+    }
 };
 
 /**
@@ -67,8 +136,7 @@ class GridHashing : public HashingScheme<T> {
 
     ull _cell_size;
     std::vector<ull> _offsets;
-    ull _hash_poly;
-    static constexpr ull _hash_mod = 2147483647;
+    CellHash _cell_hash;
   protected:
     ull inline normalize_coord(const point& p, int i) const {
         return HashingScheme<T>::normalize_coord(p, i) + _offsets[i];
@@ -78,32 +146,28 @@ class GridHashing : public HashingScheme<T> {
 
     const int dimension() const { return _dimension; }
     const ull cell_size() const { return _cell_size; }
-    const ull hash_poly() const { return _hash_poly; }
-    const ull hash_mod() const { return _hash_mod; }
+    const ull hash_poly() const { return _cell_hash.hash_poly(); }
+    const ull hash_mod() const { return _cell_hash.hash_mod(); }
 
     /**
      * @brief Constructs a GridHashing instance.
      *
      * @param dim The dimension of the space.
      * @param radius The radius for subsequent calls to `eval_ball`.
+     * @param cell_hash The function combining cell coordinates into a bucket hash.
      */
-    GridHashing(int dim, double radius) {
-        _dimension = dim;
+    GridHashing(int dim, double radius, CellHashChoice cell_hash = KeyedCellHash)
+        : _dimension(dim), _offsets(this->random_offsets(dim)), _cell_hash(dim, cell_hash) {
         // Setting cell_size to be dim-times bigger actually provides
         // great speedup with better results
         _cell_size = dim * 2.0 * radius * scale;
-
-        _offsets.resize(_dimension, 0);
-        for (int i=0; i<_dimension; i++) {
-            _offsets[i] = randRange((ull) 0, std::numeric_limits<ull>::max());
-        } 
-
-        _hash_poly = randRange(2, std::numeric_limits<int>::max());
     }
 
+    int cell_dimension() const override { return _dimension; }
+
     // Fot testing purposes only
-    static GridHashing<T> manual(int dim, ull cs, const std::vector<ull> &offsets = std::vector<ull>()) {
-        GridHashing<T> gh(dim, 1);
+    static GridHashing<T> manual(int dim, ull cs, const std::vector<ull> &offsets = std::vector<ull>(), CellHashChoice cell_hash = PolynomialCellHash) {
+        GridHashing<T> gh(dim, 1, cell_hash);
         gh._cell_size = cs;
         if (offsets.size() != 0) {
             gh._offsets = offsets;
@@ -118,39 +182,54 @@ class GridHashing : public HashingScheme<T> {
      * @return The hash value of the bucket.
      */
     ull hash(const point& p) const override {
-        std::vector<ull> cell(_dimension);
+        INSTR_COUNT("grid_hashing.hash", 1);
+        return _cell_hash([&](int i) { return this->normalize_coord(p, i) / _cell_size; });
+    }
+
+    /**
+     * @brief For a given point, gives its bucket's cell and the bucket hash. Takes O(d) time.
+     *
+     * @param point The point to hash.
+     * @param cell Output array of d cell coordinates.
+     * @return The hash value of the bucket.
+     */
+    ull hash(const point& p, ull* cell) const override {
+        INSTR_COUNT("grid_hashing.hash", 1);
         for (int i=0; i<_dimension; i++) {
             cell[i] = this->normalize_coord(p, i) / _cell_size;
         }
-        ull hash = 0;
-        for (int i=0; i<_dimension; i++) {
-            hash *= _hash_poly;
-            hash %= _hash_mod;
-            hash += cell[i];
-            hash %= _hash_mod;
-        }
-        return hash;
+        return _cell_hash([&](int i) { return cell[i]; });
     }
 
 
     /**
      * @brief Determines whether bucket intersects with a sphere
      *
+     * Works on the integer coordinates and compares squared distances in scaled units,
+     * stopping as soon as the partial distance exceeds the radius.
+     *
      * @param center The center of the sphere.
      * @param radius The radius of the sphere.
      * @param point A point in the bucket.
      * @return `true` if bucket and sphere intersect, `false` otherwise
      */
-    bool bucket_sphere_intersect(const point& center, double radius, point bucket) const {
+    bool bucket_sphere_intersect(const point& center, double radius, const point& bucket) const {
+        double bound = radius * scale;
+        bound *= bound;
+        double dist2 = 0;
         for (int i=0; i<_dimension; i++) {
             ull offset = normalize_coord(bucket, i) % _cell_size;
+            ll closest = bucket.coords[i];
             if (bucket.coords[i] > center.coords[i]) {
-                bucket.coords[i] -= offset;
+                closest = (ull) closest - offset;
             } else if (bucket.coords[i] < center.coords[i]) {
-                bucket.coords[i] += _cell_size - offset - 1;
+                closest = (ull) closest + _cell_size - offset - 1;
             }
+            double delta = (double) closest - (double) center.coords[i];
+            dist2 += delta*delta;
+            if (dist2 > bound) return false;
         }
-        return center.dist_squared(bucket) <= radius * radius;
+        return true;
     }
 
     /**
@@ -159,6 +238,7 @@ class GridHashing : public HashingScheme<T> {
      *     B_P(p, r) ⊆ A_P(p, r) ⊆ B(p, 3𝚪r)
      *
      * Uses bfs to find all intersecting buckets. Takes O(2^d d^2) time.
+     * Visited cells are told apart like the buckets of the table (see `BucketSet`).
      *
      * @param center The center of the approximated ball.
      * @param radius The radius r determining size of the approximated ball. Must be ≤ `radius` used in construction.
@@ -170,25 +250,27 @@ class GridHashing : public HashingScheme<T> {
         const tagged_point& center,
         const double radius,
         const Composable::Composable<T>& f,
-        const std::unordered_map<ull, T>& bucket_values
+        const BucketTable<T>& bucket_values
     ) const override {
         T result = f.empty_value;
 
         std::queue<point> neighborhood;
         neighborhood.push(center);
-        std::unordered_set<ull> found_cells;
+        BucketSet found_cells(bucket_values.exact(), _dimension);
+        std::vector<ull> cell(_dimension);
+        ull buckets_hit = 0;
 
         while (neighborhood.size()) {
             point p = neighborhood.front(); neighborhood.pop();
-            ull hash_of_p = hash(p);
+            ull hash_of_p = hash(p, cell.data());
 
-            if (found_cells.count(hash_of_p) > 0)
+            if (!found_cells.insert(hash_of_p, cell.data()))
                 continue;
-            found_cells.insert(hash_of_p);
 
-            auto bucket_val = bucket_values.find(hash_of_p);
-            if (bucket_val != bucket_values.end()) {
-                result = f.compose(result, bucket_val->second);
+            const T* bucket_val = bucket_values.find(hash_of_p, cell.data());
+            if (bucket_val != NULL) {
+                result = f.compose(result, *bucket_val);
+                buckets_hit++;
             }
 
             for (int ix=0; ix<2*_dimension; ix++) {
@@ -201,8 +283,117 @@ class GridHashing : public HashingScheme<T> {
                     neighborhood.push(q);
             }
         }
+        INSTR_RECORD("grid_hashing.eval_ball.cells_visited", found_cells.size());
+        INSTR_RECORD("grid_hashing.eval_ball.buckets_hit", buckets_hit);
         return result;
     }
+
+    /**
+     * @brief Calls visit on the cell of every bucket other than the center's own that intersects a sphere.
+     *
+     * Cells are at least 2r wide, so intersecting cells differ from the own cell by at most one
+     * in coordinates where the center is within r of a face, and by zero elsewhere. Only these
+     * boundary coordinates are branched on, with the same distance test as `bucket_sphere_intersect`.
+     *
+     * @param center The center of the sphere.
+     * @param radius The radius of the sphere.
+     * @param cell The cell of the center, modified during the search and restored afterwards.
+     * @param visit Function called with the cell coordinates of each intersecting bucket.
+     */
+    template<typename F>
+    void for_each_boundary_cell(const point& center, double radius, ull* cell, F&& visit) const {
+        double bound = radius * scale;
+        bound *= bound;
+
+        // Boundary coordinates with squared distances to the lower and upper face
+        std::vector<std::tuple<int, double, double>> faces;
+        for (int i=0; i<_dimension; i++) {
+            ull offset = normalize_coord(center, i) % _cell_size;
+            double below = (double) (ll) ((ull) center.coords[i] - offset - 1) - (double) center.coords[i];
+            double above = (double) (ll) ((ull) center.coords[i] + _cell_size - offset) - (double) center.coords[i];
+            if (below*below <= bound || above*above <= bound)
+                faces.emplace_back(i, below*below, above*above);
+        }
+
+        auto search = [&](auto&& self, size_t j, double dist2, bool moved) -> void {
+            if (j == faces.size()) {
+                if (moved) visit(cell);
+                return;
+            }
+            self(self, j+1, dist2, moved);
+            auto [i, below, above] = faces[j];
+            if (dist2 + below <= bound) {
+                cell[i]--;
+                self(self, j+1, dist2 + below, true);
+                cell[i]++;
+            }
+            if (dist2 + above <= bound) {
+                cell[i]++;
+                self(self, j+1, dist2 + above, true);
+                cell[i]--;
+            }
+        };
+        search(search, 0, 0.0, false);
+    }
+
+    /// Buckets are the cells intersecting B(p, r), of diameter √d times the cell size.
+    double ball_extent(double radius) const override {
+        return radius + sqrt(_dimension) * _cell_size / scale;
+    }
+
+    bool batches_queries() const override { return true; }
+
+    /**
+     * @brief Evaluates a composable function f on approximations of balls around a batch of points with the same hash.
+     *
+     * Gives the same results as `eval_ball`. The own bucket is looked up once for the whole batch,
+     * and each point only tests the boundary cells of its ball; their values are shared among the batch
+     * by hash, unless buckets are exact, in which case cells with colliding hashes must be looked up separately.
+     */
+    void eval_ball_batch(
+        const tagged_point* const* centers,
+        size_t count,
+        const double radius,
+        const Composable::Composable<T>& f,
+        const BucketTable<T>& bucket_values,
+        T* results
+    ) const override {
+        std::vector<ull> bucket_cell(_dimension), cell(_dimension);
+        ull bucket_hash = hash(*centers[0], bucket_cell.data());
+        const T* bucket_val = bucket_values.find(bucket_hash, bucket_cell.data());
+        T bucket_result = bucket_val != NULL ? f.compose(f.empty_value, *bucket_val) : f.empty_value;
+
+        std::unordered_map<ull, const T*> neighbor_values;
+        for (size_t k=0; k<count; k++) {
+            const tagged_point& center = *centers[k];
+            if (hash(center, cell.data()) != bucket_hash || cell != bucket_cell) {
+                results[k] = eval_ball(center, radius, f, bucket_values);
+                continue;
+            }
+
+            T result = bucket_result;
+            ull cells_visited = 1, buckets_hit = bucket_val != NULL;
+            for_each_boundary_cell(center, radius, cell.data(), [&](const ull* neighbor) {
+                ull neighbor_hash = _cell_hash([&](int i) { return neighbor[i]; });
+                const T* value;
+                if (count > 1 && !bucket_values.exact()) {
+                    auto [it, inserted] = neighbor_values.try_emplace(neighbor_hash, nullptr);
+                    if (inserted) it->second = bucket_values.find(neighbor_hash, neighbor);
+                    value = it->second;
+                } else {
+                    value = bucket_values.find(neighbor_hash, neighbor);
+                }
+                if (value != NULL) {
+                    result = f.compose(result, *value);
+                    buckets_hit++;
+                }
+                cells_visited++;
+            });
+            INSTR_RECORD("grid_hashing.eval_ball.cells_visited", cells_visited);
+            INSTR_RECORD("grid_hashing.eval_ball.buckets_hit", buckets_hit);
+            results[k] = result;
+        }
+    }
 };
 
 /**
@@ -218,31 +409,36 @@ class FaceHashing : public HashingScheme<T> {
 
     ull _hypercube_side;
     ull _epsilon;
-    ull _hash_poly;
-    static constexpr ull _hash_mod = 2147483647;
+    CellHash _cell_hash;
     static constexpr double gamma_mul = 3.0; // must be >= 3.0 for theoretical guarantees
   public:
     static double Gamma(int dimension) { return gamma_mul * dimension * sqrt(dimension); }
 
     int const dimension() const { return _dimension; }
     ull const hypercube_side() const { return _hypercube_side; }
-    ull const hash_poly() const { return _hash_poly; }
-    ull const hash_mod() const { return _hash_mod; }
+    ull const hash_poly() const { return _cell_hash.hash_poly(); }
+    ull const hash_mod() const { return _cell_hash.hash_mod(); }
 
     /**
      * @brief Constructs a FaceHashing instance.
      *
      * @param dim The dimension of the space.
      * @param radius The radius for subsequent calls to `eval_ball`.
+     * @param cell_hash The function combining cell coordinates into a bucket hash.
      */
-    FaceHashing(int dim, double radius) {
-        _dimension = dim;
+    FaceHashing(int dim, double radius, CellHashChoice cell_hash = KeyedCellHash)
+        : _dimension(dim), _cell_hash(dim, cell_hash) {
         _hypercube_side = 2*radius*scale * Gamma(dim)/sqrt(dim);
         _epsilon = 2*radius*scale;
+    }
 
-        _hash_poly = randRange(2, std::numeric_limits<int>::max());
+    /// Buckets contain a point of B(p, r) and span at most a hypercube widened by dε in every coordinate.
+    double ball_extent(double radius) const override {
+        return radius + sqrt(_dimension) * ((double) _hypercube_side + 2.0 * _dimension * _epsilon) / scale;
     }
 
+    int cell_dimension() const override { return _dimension; }
+
     /**
      * @brief For a given point, gives a hash representing the bucket it belongs to. Takes O(d) time.
      *
@@ -250,7 +446,21 @@ class FaceHashing : public HashingScheme<T> {
      * @return The hash value of the bucket.
      */
     ull hash(const point& p) const override {
-        std::vector<ull> p_norm(_dimension);
+        std::vector<ull> cell(_dimension);
+        return hash(p, cell.data());
+    }
+
+    /**
+     * @brief For a given point, gives its bucket's cell and the bucket hash. Takes O(d) time.
+     *
+     * @param point The point to hash.
+     * @param cell Output array of d cell coordinates.
+     * @return The hash value of the bucket.
+     */
+    ull hash(const point& p, ull* cell) const override {
+        INSTR_COUNT("face_hashing.hash", 1);
+        // normalized coordinates are computed in place of the cell
+        ull* p_norm = cell;
         for (int i=0; i<_dimension; i++) {
             p_norm[i] = this->normalize_coord(p, i);
         }
@@ -287,15 +497,10 @@ class FaceHashing : public HashingScheme<T> {
                 p_norm[i] += (_hypercube_side+1)/2 - alpha;
         }
 
-        // compute hash
-        ull hash = 0;
         for (int i=0; i<_dimension; i++) {
-            hash *= _hash_poly;
-            hash %= _hash_mod;
-            hash += 2*p_norm[i] / _hypercube_side;
-            hash %= _hash_mod;
+            cell[i] = 2*p_norm[i] / _hypercube_side;
         }
-        return hash;
+        return _cell_hash([&](int i) { return cell[i]; });
     }
 
     /**
@@ -316,7 +521,7 @@ class FaceHashing : public HashingScheme<T> {
         const tagged_point& center,
         const double radius,
         const Composable::Composable<T>& f,
-        const std::unordered_map<ull, T>& bucket_values
+        const BucketTable<T>& bucket_values
     ) const override {
         T result = f.empty_value;
         std::vector<std::tuple<int, ull, ull>> differences(_dimension);
@@ -327,6 +532,11 @@ class FaceHashing : public HashingScheme<T> {
         std::sort(differences.begin(), differences.end(), [](const auto& p, const auto& q) {
             return std::get<2>(p) < std::get<2>(q);
         });
+        std::vector<ull> candidates;
+        candidates.reserve(_dimension + 1);
+        std::vector<ull> candidate_cells((_dimension + 1) * _dimension);
+        double bound = radius * scale;
+        bound *= bound;
 
         for (int face_dim=0; face_dim <= _dimension; face_dim++) {
             point closest(center);
@@ -347,13 +557,467 @@ class FaceHashing : public HashingScheme<T> {
                     else                              closest[index] += (i+1)*_epsilon - offset;
                 }
             }
-            if (center.dist(closest) < radius) {
-                auto bucket_val = bucket_values.find(hash(closest));
-                if (bucket_val != bucket_values.end()) {
-                    result = f.compose(result, bucket_val->second);
+            if (center.dist_squared_scaled(closest) < bound) {
+                candidates.push_back(hash(closest, &candidate_cells[candidates.size() * _dimension]));
+            }
+        }
+
+        std::vector<const T*> candidate_values(candidates.size());
+        bucket_values.find_batch(candidates.data(), candidate_cells.data(), candidates.size(), candidate_values.data());
+        ull buckets_hit = 0;
+        for (const T* bucket_val: candidate_values) {
+            if (bucket_val != NULL) {
+                result = f.compose(result, *bucket_val);
+                buckets_hit++;
+            }
+        }
+        INSTR_RECORD("face_hashing.eval_ball.buckets_probed", candidates.size());
+        INSTR_RECORD("face_hashing.eval_ball.buckets_hit", buckets_hit);
+        return result;
+    }
+};
+
+/**
+ * @brief Consistent geometric hashing by Voronoi cells of the D_n lattice
+ *        (integer vectors with even sum of coordinates) scaled by s and randomly shifted.
+ *
+ * Closest lattice points are found in O(d) time by rounding every coordinate
+ * and, if the sum is odd, rounding the worst coordinate the other way (Conway–Sloane).
+ * The Voronoi cells are rounder than hypercubes, so a ball intersects fewer of them
+ * for the same covering radius.
+ *
+ * `Gamma` gives 𝚪 = √d as for GridHashing, which sizes the cells (lattice scale s = d𝚪r/ρ for the covering
+ * radius ρs) but does not bound the balls: A_P(p, r) ⊆ B(p, √d(r+s) + ρs) by `ball_extent`, that is B(p, √d(1+3d)r) for d ≥ 4.
+ *
+ * @tparam T The type of the result of composable function for ball evaluation.
+ */
+template<typename T>
+class LatticeHashing : public HashingScheme<T> {
+  private:
+    int _dimension;
+
+    ull _lattice_scale;
+    std::vector<ull> _offsets;
+    std::vector<std::array<int, 4>> _neighbors;
+    CellHash _cell_hash;
+
+    /// Covering radius of D_n relative to its scale.
+    static double covering_factor(int dimension) { return std::max(1.0, sqrt(dimension) / 2); }
+
+    ull inline normalize_coord(const point& p, int i) const {
+        return HashingScheme<T>::normalize_coord(p, i) + _offsets[i];
+    }
+
+  public:
+    static double Gamma(int dimension) { return sqrt(dimension); }
+
+    const int dimension() const { return _dimension; }
+    const ull lattice_scale() const { return _lattice_scale; }
+
+    /**
+     * @brief Constructs a LatticeHashing instance.
+     *
+     * @param dim The dimension of the space.
+     * @param radius The radius for subsequent calls to `eval_ball`.
+     * @param cell_hash The function combining cell coordinates into a bucket hash.
+     */
+    LatticeHashing(int dim, double radius, CellHashChoice cell_hash = KeyedCellHash)
+        : _dimension(dim), _offsets(this->random_offsets(dim)), _cell_hash(dim, cell_hash) {
+        // As in GridHashing, cells dim-times bigger than the covering radius 𝚪r
+        // give great speedup with better results
+        _lattice_scale = std::max(2.0, dim * Gamma(dim) * radius * scale / covering_factor(dim));
+
+        // Relevant vectors ±e_i±e_j and ±2e_i, as changes {i, a, j, b} of coordinates i and j
+        for (int i=0; i<dim; i++) {
+            _neighbors.push_back({i, 2, i, 0});
+            _neighbors.push_back({i, -2, i, 0});
+            for (int j=i+1; j<dim; j++) {
+                for (int a: {-1, 1}) {
+                    for (int b: {-1, 1}) {
+                        _neighbors.push_back({i, a, j, b});
+                    }
                 }
             }
         }
+    }
+
+    int cell_dimension() const override { return _dimension; }
+
+    /// Visited lattice points differ from p by at most r+s in every coordinate, their cells have radius at most the covering radius.
+    double ball_extent(double radius) const override {
+        return (sqrt(_dimension) * (radius * scale + _lattice_scale) + covering_factor(_dimension) * _lattice_scale) / scale;
+    }
+
+    ull hash(const point& p) const override {
+        std::vector<ull> cell(_dimension);
+        return hash(p, cell.data());
+    }
+
+    /**
+     * @brief For a given point, gives its bucket's cell (closest lattice point divided by s) and the bucket hash.
+     *        Takes O(d) time.
+     *
+     * @param point The point to hash.
+     * @param cell Output array of d cell coordinates.
+     * @return The hash value of the bucket.
+     */
+    ull hash(const point& p, ull* cell) const override {
+        INSTR_COUNT("lattice_hashing.hash", 1);
+        ull parity = 0;
+        int worst = 0;
+        ull worst_error = 0;
+        ull worst_direction = 1;
+        for (int i=0; i<_dimension; i++) {
+            ull x = normalize_coord(p, i);
+            ull q = x / _lattice_scale, rem = x % _lattice_scale;
+            ull error = rem, direction = 1;
+            if (rem >= _lattice_scale - rem) {
+                q++;
+                error = _lattice_scale - rem;
+                direction = -1;
+            }
+            cell[i] = q;
+            parity ^= q & 1;
+            if (error >= worst_error) {
+                worst = i;
+                worst_error = error;
+                worst_direction = direction;
+            }
+        }
+        if (parity) cell[worst] += worst_direction;
+        return _cell_hash([&](int i) { return cell[i]; });
+    }
+
+    /**
+     * @brief Evaluates a composable function f on approximation of a ball A_P(p, r).
+     *
+     *     B_P(p, r) ⊆ A_P(p, r) ⊆ B(p, √d(r+s) + ρs)
+     *
+     * for the lattice scale s = d𝚪r/ρ and the covering radius ρs of the cells (see `ball_extent`),
+     * as cells are d times bigger than the covering radius 𝚪r.
+     * Searches Voronoi cells from the cell of the center through the relevant vectors.
+     * The cell of lattice point v lies on the side of v of the bisector with v+w for every relevant vector w,
+     * so it misses the ball unless all |p_i-v_i| ≤ r+s and all |p_i-v_i| + |p_j-v_j| ≤ √2r+s.
+     * Only the two changed coordinates and the three largest differences of the current cell
+     * are needed to check a neighbor, which takes O(1) time.
+     *
+     * @param center The center of the approximated ball.
+     * @param radius The radius r determining size of the approximated ball. Must be ≤ `radius` used in construction.
+     * @param f The composable function to evaluate.
+     * @param bucket_values The results of composable function on each bucket separately.
+     * @return The vector of results of f on each A_P(p, r).
+     */
+    T eval_ball(
+        const tagged_point& center,
+        const double radius,
+        const Composable::Composable<T>& f,
+        const BucketTable<T>& bucket_values
+    ) const override {
+        T result = f.empty_value;
+        std::vector<ull> x(_dimension);
+        for (int i=0; i<_dimension; i++) {
+            x[i] = normalize_coord(center, i);
+        }
+        double s = _lattice_scale;
+        double max_delta = radius * scale + s;
+        double max_pair = sqrt(2) * radius * scale + s;
+
+        std::vector<ull> cells(_dimension);
+        BucketSet found_cells(bucket_values.exact(), _dimension);
+        found_cells.insert(hash(center, cells.data()), cells.data());
+        std::vector<double> delta(_dimension);
+        std::vector<ull> cell(_dimension);
+        ull buckets_hit = 0;
+        for (size_t head=0; head<cells.size(); head+=_dimension) {
+            const ull* head_cell = &cells[head];
+            const T* bucket_val = bucket_values.find(_cell_hash([&](int i) { return head_cell[i]; }), head_cell);
+            if (bucket_val != NULL) {
+                result = f.compose(result, *bucket_val);
+                buckets_hit++;
+            }
+
+            // Differences of the center from the lattice point and indices of the three largest
+            int top[3] = {-1, -1, -1};
+            for (int d=0; d<_dimension; d++) {
+                delta[d] = (double) (ll) (x[d] - head_cell[d] * _lattice_scale);
+                int k = 3;
+                while (k > 0 && (top[k-1] == -1 || std::abs(delta[top[k-1]]) < std::abs(delta[d]))) {
+                    if (k < 3) top[k] = top[k-1];
+                    k--;
+                }
+                if (k < 3) top[k] = d;
+            }
+
+            for (auto [i, a, j, b]: _neighbors) {
+                double changed_i = std::abs(delta[i] - a*s);
+                double changed_j = std::abs(delta[j] - b*s);
+                if (changed_i > max_delta || changed_j > max_delta)
+                    continue;
+
+                double first = changed_i, second = i == j ? 0 : changed_j;
+                if (first < second) std::swap(first, second);
+                int unchanged = 0;
+                for (int k=0; k<3 && unchanged<2; k++) {
+                    if (top[k] == -1 || top[k] == i || top[k] == j) continue;
+                    double value = std::abs(delta[top[k]]);
+                    if (value > first) {
+                        second = first;
+                        first = value;
+                    } else if (value > second) {
+                        second = value;
+                    }
+                    unchanged++;
+                }
+                if (first + second > max_pair)
+                    continue;
+
+                std::copy(head_cell, head_cell + _dimension, cell.begin());
+                cell[i] += a;
+                cell[j] += b;
+                if (found_cells.insert(_cell_hash([&](int i) { return cell[i]; }), cell.data()))
+                    cells.insert(cells.end(), cell.begin(), cell.end());
+            }
+        }
+        INSTR_RECORD("lattice_hashing.eval_ball.cells_visited", cells.size() / _dimension);
+        INSTR_RECORD("lattice_hashing.eval_ball.buckets_hit", buckets_hit);
+        return result;
+    }
+};
+
+/**
+ * @brief Hashing by ball carving in a random low-dimensional projection (Andoni–Indyk LSH).
+ *
+ * Points are projected to m dimensions by a Gaussian matrix scaled by 1/√m. Then L shifted grids
+ * of disjoint balls of radius w = 2r (centers spaced 2w apart) are tried in order and a point belongs to the first
+ * ball containing it. Points covered by no ball fall into the hypercube cells of side 2w.
+ * All costs depend on d only through the projection, so hashing takes O(dm + Lm) time
+ * and `eval_ball` takes O(dm + L (2+s)^m m) time for the stretch s of `stretch`.
+ *
+ * The projection stretches a distance by more than s with probability at most δ = 2^-30 (see `stretch`),
+ * so `eval_ball` searches the projected ball of radius sr and B_P(p, r) ⊆ A_P(p, r) fails for each pair
+ * of points at most with probability δ. The projection has no such bound on contracting distances, so buckets
+ * are bounded only in the projected space, where the hypercube cells of diameter 2w√m give 𝚪 = 2√m.
+ * (𝚪=2√m, Λ = L·(2+s)^m)
+ *
+ * @tparam T The type of the result of composable function for ball evaluation.
+ */
+template<typename T>
+class LSHHashing : public HashingScheme<T> {
+  private:
+    int _dimension;
+    int _projections;
+    int _tables;
+    double _ball_radius;
+    double _stretch;
+    std::vector<double> _projection;
+    std::vector<double> _shifts;
+    CellHash _cell_hash;
+
+    static std::vector<double> random_projection(int dim, int projections) {
+        std::vector<double> projection(projections * dim);
+        for (double& x: projection) {
+            x = randNormal(0.0, 1.0) / sqrt(projections);
+        }
+        return projection;
+    }
+
+    void project(const point& p, double* y) const {
+        for (int j=0; j<_projections; j++) {
+            const double* row = &_projection[j * _dimension];
+            double value = 0;
+            for (int i=0; i<_dimension; i++) {
+                value += row[i] * p.coords[i];
+            }
+            y[j] = value;
+        }
+    }
+
+    /**
+     * @brief Calls visit(cell) for each ball of table g whose center is within `reach` of y.
+     *        Coordinates of the cell are the table index followed by the lattice index of the center.
+     */
+    template<typename F>
+    void for_each_ball(const double* y, int g, double reach, ull* cell, F&& visit) const {
+        const double* shift = &_shifts[g * _projections];
+        double spacing = 2 * _ball_radius;
+        std::vector<ll> lo(_projections), hi(_projections), idx(_projections);
+        for (int j=0; j<_projections; j++) {
+            lo[j] = ceil((y[j] - shift[j] - reach) / spacing);
+            hi[j] = floor((y[j] - shift[j] + reach) / spacing);
+            if (lo[j] > hi[j]) return;
+            idx[j] = lo[j];
+        }
+        cell[0] = g;
+        while (true) {
+            double dist2 = 0;
+            for (int j=0; j<_projections; j++) {
+                double delta = y[j] - (shift[j] + spacing * idx[j]);
+                dist2 += delta*delta;
+                cell[j+1] = idx[j];
+            }
+            if (dist2 <= reach * reach) visit(cell);
+
+            int j = 0;
+            while (j < _projections && idx[j] == hi[j]) {
+                idx[j] = lo[j];
+                j++;
+            }
+            if (j == _projections) break;
+            idx[j]++;
+        }
+    }
+
+  public:
+    /// Ratio of the radius w of the carved balls to r.
+    static constexpr double ball_radius_mul = 2.0;
+    /// Probability δ that the projection stretches the distance of a pair of points by more than `stretch`.
+    static constexpr double stretch_failure = 0x1p-30;
+
+    /// Half the diameter of the hypercube cells relative to r, w√m/r (the balls are smaller).
+    static double Gamma(int dimension, int projections) { return ball_radius_mul * sqrt(std::min(dimension, projections)); }
+
+    /**
+     * @brief Gives s such that the projection to m dimensions stretches a distance by more than s with probability at most δ.
+     *
+     * The squared stretch is χ²_m / m, and P(χ²_m ≥ m + 2√(mt) + 2t) ≤ e^-t (Laurent–Massart) for t = ln(1/δ).
+     */
+    static double stretch(int projections) {
+        double t = -log(stretch_failure);
+        return sqrt(1 + 2 * sqrt(t / projections) + 2 * t / projections);
+    }
+
+    const int dimension() const { return _dimension; }
+    const int projections() const { return _projections; }
+    const int tables() const { return _tables; }
+
+    /**
+     * @brief Constructs a LSHHashing instance.
+     *
+     * @param dim The dimension of the space.
+     * @param radius The radius for subsequent calls to `eval_ball`.
+     * @param tables The number L of shifted ball grids.
+     * @param projections The dimension m of the projection (at most d).
+     * @param cell_hash The function combining cell coordinates into a bucket hash.
+     */
+    LSHHashing(int dim, double radius, int tables, int projections, CellHashChoice cell_hash = KeyedCellHash)
+        : _dimension(dim), _projections(std::min(dim, projections)), _tables(tables),
+          _projection(random_projection(dim, _projections)), _cell_hash(_projections + 1, cell_hash) {
+        _ball_radius = ball_radius_mul * radius * scale;
+        _stretch = stretch(_projections);
+        _shifts.resize(_tables * _projections);
+        for (double& shift: _shifts) {
+            shift = randDouble(0, 2 * _ball_radius);
+        }
+    }
+
+    int cell_dimension() const override { return _projections + 1; }
+
+    ull hash(const point& p) const override {
+        std::vector<ull> cell(_projections + 1);
+        return hash(p, cell.data());
+    }
+
+    /**
+     * @brief For a given point, gives its bucket's cell and the bucket hash. Takes O(dm + Lm) time.
+     *
+     * @param point The point to hash.
+     * @param cell Output array of m+1 cell coordinates.
+     * @return The hash value of the bucket.
+     */
+    ull hash(const point& p, ull* cell) const override {
+        INSTR_COUNT("lsh_hashing.hash", 1);
+        std::vector<double> y(_projections);
+        project(p, y.data());
+
+        double spacing = 2 * _ball_radius;
+        for (int g=0; g<_tables; g++) {
+            const double* shift = &_shifts[g * _projections];
+            double dist2 = 0;
+            for (int j=0; j<_projections; j++) {
+                ll idx = llround((y[j] - shift[j]) / spacing);
+                double delta = y[j] - (shift[j] + spacing * idx);
+                dist2 += delta*delta;
+                cell[j+1] = idx;
+            }
+            if (dist2 <= _ball_radius * _ball_radius) {
+                cell[0] = g;
+                return _cell_hash([&](int i) { return cell[i]; });
+            }
+        }
+
+        cell[0] = _tables;
+        for (int j=0; j<_projections; j++) {
+            cell[j+1] = (ll) floor(y[j] / spacing);
+        }
+        return _cell_hash([&](int i) { return cell[i]; });
+    }
+
+    /**
+     * @brief Evaluates a composable function f on approximation of a ball A_P(p, r).
+     *
+     * Visits every ball within distance sr of the projected center in each of the L grids
+     * and every hypercube cell intersecting the projected ball of radius sr, for the stretch s of `stretch`.
+     * Takes O(dm + L (2+s)^m m) time.
+     *
+     * @param center The center of the approximated ball.
+     * @param radius The radius r determining size of the approximated ball. Must be ≤ `radius` used in construction.
+     * @param f The composable function to evaluate.
+     * @param bucket_values The results of composable function on each bucket separately.
+     * @return The vector of results of f on each A_P(p, r).
+     */
+    T eval_ball(
+        const tagged_point& center,
+        const double radius,
+        const Composable::Composable<T>& f,
+        const BucketTable<T>& bucket_values
+    ) const override {
+        T result = f.empty_value;
+        std::vector<double> y(_projections);
+        project(center, y.data());
+        std::vector<ull> cell(_projections + 1);
+        double reach = _stretch * radius * scale;
+        ull buckets_probed = 0, buckets_hit = 0;
+
+        auto visit = [&](const ull* cell) {
+            buckets_probed++;
+            const T* bucket_val = bucket_values.find(_cell_hash([&](int i) { return cell[i]; }), cell);
+            if (bucket_val != NULL) {
+                result = f.compose(result, *bucket_val);
+                buckets_hit++;
+            }
+        };
+        for (int g=0; g<_tables; g++) {
+            for_each_ball(y.data(), g, _ball_radius + reach, cell.data(), visit);
+        }
+
+        // Hypercube cells of uncovered points intersecting the projected ball
+        double spacing = 2 * _ball_radius;
+        std::vector<ll> lo(_projections), hi(_projections), idx(_projections);
+        for (int j=0; j<_projections; j++) {
+            lo[j] = idx[j] = floor((y[j] - reach) / spacing);
+            hi[j] = floor((y[j] + reach) / spacing);
+        }
+        cell[0] = _tables;
+        while (true) {
+            double dist2 = 0;
+            for (int j=0; j<_projections; j++) {
+                double nearest = std::clamp(y[j], spacing * idx[j], spacing * (idx[j] + 1));
+                dist2 += (y[j] - nearest) * (y[j] - nearest);
+                cell[j+1] = idx[j];
+            }
+            if (dist2 <= reach * reach) visit(cell.data());
+
+            int j = 0;
+            while (j < _projections && idx[j] == hi[j]) {
+                idx[j] = lo[j];
+                j++;
+            }
+            if (j == _projections) break;
+            idx[j]++;
+        }
+
+        INSTR_RECORD("lsh_hashing.eval_ball.buckets_probed", buckets_probed);
+        INSTR_RECORD("lsh_hashing.eval_ball.buckets_hit", buckets_hit);
         return result;
     }
 };
@@ -363,8 +1027,27 @@ class FaceHashing : public HashingScheme<T> {
  * @brief Represent a choice of hashing scheme.
  * - GridHashingScheme translates to GridHashing<T>
  * - FaceHashingScheme translates to FaceHashing<T>
+ * - LSHHashingScheme translates to LSHHashing<T> with `lsh_parameters`
+ * - LatticeHashingScheme translates to LatticeHashing<T>
  */
-enum HashingSchemeChoice {GridHashingScheme, FaceHashingScheme};
+enum HashingSchemeChoice {GridHashingScheme, FaceHashingScheme, LSHHashingScheme, LatticeHashingScheme};
+
+/**
+ * @brief Parameters of LSHHashing used for LSHHashingScheme.
+ */
+struct LSHParameters {
+    int tables = 16; ///< The number L of shifted ball grids
+    int projections = 4; ///< The dimension m of the projection
+};
+
+/// Parameters of LSHHashing used for LSHHashingScheme.
+extern LSHParameters lsh_parameters;
+
+/// How buckets are identified in the bucket tables built by `eval_composable` (HashBucketIdentity by default).
+extern BucketIdentity bucket_identity;
+
+/// Memory budget in bytes of the bucket tables cached by a clustering run (see `BucketTableCache`), 0 disables the cache.
+extern size_t bucket_cache_budget;
 
 /**
  * @brief Gets gamma for hashing scheme choice
@@ -388,10 +1071,29 @@ std::unique_ptr<HashingScheme<T>> make_hashing_scheme(HashingSchemeChoice hs_cho
     switch (hs_choice) {
         case GridHashingScheme: return std::make_unique<GridHashing<T>>(dimension, radius);
         case FaceHashingScheme: return std::make_unique<FaceHashing<T>>(dimension, radius);
+        case LSHHashingScheme:  return std::make_unique<LSHHashing<T>>(dimension, radius, lsh_parameters.tables, lsh_parameters.projections);
+        case LatticeHashingScheme: return std::make_unique<LatticeHashing<T>>(dimension, radius);
         default: throw std::invalid_argument("Unsupported hashing scheme");
     }
 }
 
+/**
+ * @brief Creates hashing scheme of choice determined by a seed and the radius, so that it can be created again
+ *        (also for another type of values) to reuse what was computed with it.
+ *        The random number generator of the calling thread is left as it was.
+ *
+ * @param hs_choice The choice of the hashing scheme.
+ * @param dimension The dimension of the space.
+ * @param radius Radius of balls for subsequent calls of eval_ball.
+ * @param scheme_seed The seed of the scheme.
+ * @return Hashing scheme instance
+ */
+template<typename T>
+std::unique_ptr<HashingScheme<T>> make_hashing_scheme(HashingSchemeChoice hs_choice, int dimension, double radius, ull scheme_seed) {
+    thread_seed_guard guard(scheme_seed ^ (std::bit_cast<ull>(radius) * 0x9E3779B97F4A7C15ULL));
+    return make_hashing_scheme<T>(hs_choice, dimension, radius);
+}
+
 /**
  * @brief Converts hashing scheme choice from string to enum.
  *
@@ -0,0 +1,114 @@
+#include <bit>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include "instrumentation.hpp"
+#include "timing.hpp"
+
+namespace instrumentation {
+    // Statistics are allocated once and never freed, so they can be safely used during exit.
+    static std::mutex registry_mutex;
+    static std::map<std::string, counter*>* counters = new std::map<std::string, counter*>();
+    static std::map<std::string, histogram*>* histograms = new std::map<std::string, histogram*>();
+    static std::map<std::string, timer*>* timers = new std::map<std::string, timer*>();
+    static bool registered_dump = false;
+
+    static void dump_at_exit() {
+        const char* output = getenv("INSTRUMENT_OUTPUT");
+        if (output == NULL) return;
+        if (std::string(output) == "-") {
+            dump(std::cerr);
+        } else {
+            std::ofstream out(output);
+            dump(out);
+        }
+    }
+
+    template<typename S>
+    static S& get(std::map<std::string, S*>& registry, const std::string& name) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (!registered_dump) {
+            atexit(dump_at_exit);
+            registered_dump = true;
+        }
+        auto it = registry.find(name);
+        if (it == registry.end()) {
+            it = registry.insert({name, new S()}).first;
+        }
+        return *it->second;
+    }
+
+    counter& get_counter(const std::string& name) { return get(*counters, name); }
+    histogram& get_histogram(const std::string& name) { return get(*histograms, name); }
+    timer& get_timer(const std::string& name) { return get(*timers, name); }
+
+    void histogram::record(ull v) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+        buckets[std::bit_width(v)].fetch_add(1, std::memory_order_relaxed);
+
+        ull current = min.load(std::memory_order_relaxed);
+        while (v < current && !min.compare_exchange_weak(current, v, std::memory_order_relaxed));
+        current = max.load(std::memory_order_relaxed);
+        while (v > current && !max.compare_exchange_weak(current, v, std::memory_order_relaxed));
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (auto& [_, c]: *counters) {
+            c->value = 0;
+        }
+        for (auto& [_, h]: *histograms) {
+            h->count = h->sum = h->max = 0;
+            h->min = std::numeric_limits<ull>::max();
+            for (auto& b: h->buckets) b = 0;
+        }
+        for (auto& [_, t]: *timers) {
+            t->calls = t->nanoseconds = 0;
+        }
+    }
+
+    void dump(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::string sep = "";
+
+        os << "{\n  \"phases\": {";
+        for (int i=0; i<PHASE_COUNT; i++) {
+            os << sep << "\n    \"" << phase_names[i] << "\": " << phase_times[i];
+            sep = ",";
+        }
+
+        os << "\n  },\n  \"counters\": {";
+        sep = "";
+        for (auto& [name, c]: *counters) {
+            os << sep << "\n    \"" << name << "\": " << c->value;
+            sep = ",";
+        }
+
+        os << "\n  },\n  \"histograms\": {";
+        sep = "";
+        for (auto& [name, h]: *histograms) {
+            ull count = h->count;
+            os << sep << "\n    \"" << name << "\": {\"count\": " << count << ", \"sum\": " << h->sum
+               << ", \"min\": " << (count ? h->min.load() : 0) << ", \"max\": " << h->max << ", \"log2_buckets\": [";
+            int last = 64;
+            while (last > 0 && h->buckets[last] == 0) last--;
+            for (int i=0; i<=last; i++) {
+                os << (i ? ", " : "") << h->buckets[i];
+            }
+            os << "]}";
+            sep = ",";
+        }
+
+        os << "\n  },\n  \"timers\": {";
+        sep = "";
+        for (auto& [name, t]: *timers) {
+            os << sep << "\n    \"" << name << "\": {\"calls\": " << t->calls
+               << ", \"seconds\": " << t->nanoseconds / 1e9 << "}";
+            sep = ",";
+        }
+        os << "\n  }\n}" << std::endl;
+    }
+}
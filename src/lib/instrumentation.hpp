@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "types.hpp"
+
+/**
+ * Lightweight instrumentation of the algorithms with counters, histograms and scoped timers.
+ *
+ * Instrumentation is compiled in only with `-D INSTRUMENT` (`make INSTRUMENT=1`), otherwise
+ * all `INSTR_*` macros expand to nothing. Collected statistics are written as JSON at exit
+ * to the file given by the `INSTRUMENT_OUTPUT` environment variable ("-" for stderr),
+ * or can be dumped explicitly with `instrumentation::dump`.
+ */
+namespace instrumentation {
+
+    /**
+     * @brief Monotonic counter.
+     */
+    struct counter {
+        std::atomic<ull> value{0};
+
+        void add(ull v) { value.fetch_add(v, std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief Distribution of recorded values with power of two buckets.
+     *
+     * Bucket i counts values v with 2^(i-1) ≤ v < 2^i (bucket 0 counts zeros).
+     */
+    struct histogram {
+        std::atomic<ull> count{0};
+        std::atomic<ull> sum{0};
+        std::atomic<ull> min{std::numeric_limits<ull>::max()};
+        std::atomic<ull> max{0};
+        std::atomic<ull> buckets[65] = {};
+
+        void record(ull v);
+    };
+
+    /**
+     * @brief Accumulates number of calls and total wall-clock time in nanoseconds.
+     */
+    struct timer {
+        std::atomic<ull> calls{0};
+        std::atomic<ull> nanoseconds{0};
+    };
+
+    /**
+     * @brief Adds the wall-clock time of its lifetime to a timer.
+     */
+    class scoped_timer {
+      private:
+        timer& _timer;
+        std::chrono::steady_clock::time_point _start;
+      public:
+        scoped_timer(timer& t) : _timer(t), _start(std::chrono::steady_clock::now()) {}
+        ~scoped_timer() {
+            auto elapsed = std::chrono::steady_clock::now() - _start;
+            _timer.calls.fetch_add(1, std::memory_order_relaxed);
+            _timer.nanoseconds.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                std::memory_order_relaxed
+            );
+        }
+    };
+
+    /**
+     * @brief Gets the statistic of a given name, creating it on first use.
+     *        The returned references stay valid until the end of the program.
+     */
+    counter& get_counter(const std::string& name);
+    histogram& get_histogram(const std::string& name);
+    timer& get_timer(const std::string& name);
+
+    /**
+     * @brief Sets all statistics to their initial values.
+     */
+    void reset();
+
+    /**
+     * @brief Writes all statistics together with phase times as a JSON object.
+     * @param os The stream to write to.
+     */
+    void dump(std::ostream& os);
+}
+
+#ifdef INSTRUMENT
+#define INSTR_CONCAT_(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT_(a, b)
+/// Adds `value` to the counter `name`.
+#define INSTR_COUNT(name, value) do { \
+        static instrumentation::counter& _instr_counter = instrumentation::get_counter(name); \
+        _instr_counter.add(value); \
+    } while (0)
+/// Records `value` into the histogram `name`.
+#define INSTR_RECORD(name, value) do { \
+        static instrumentation::histogram& _instr_histogram = instrumentation::get_histogram(name); \
+        _instr_histogram.record(value); \
+    } while (0)
+/// Times the rest of the enclosing scope into the timer `name`.
+#define INSTR_TIMER(name) \
+    static instrumentation::timer& INSTR_CONCAT(_instr_timer_, __LINE__) = instrumentation::get_timer(name); \
+    instrumentation::scoped_timer INSTR_CONCAT(_instr_scoped_timer_, __LINE__)(INSTR_CONCAT(_instr_timer_, __LINE__))
+#else
+#define INSTR_COUNT(name, value) ((void) sizeof(value))
+#define INSTR_RECORD(name, value) ((void) sizeof(value))
+#define INSTR_TIMER(name) ((void) 0)
+#endif
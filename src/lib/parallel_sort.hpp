@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <omp.h>
+
+/**
+ * @brief Sorts a vector using all available threads.
+ *
+ * The vector is split into one chunk per thread, chunks are sorted in parallel
+ * and then merged pairwise in log(threads) parallel rounds.
+ *
+ * @tparam T The type of the sorted values.
+ * @tparam Compare The type of the comparator.
+ * @param values The values to sort.
+ * @param cmp The comparator.
+ */
+template<typename T, typename Compare = std::less<T>>
+void parallel_sort(std::vector<T>& values, Compare cmp = Compare()) {
+    constexpr size_t min_chunk_size = 1 << 14;
+    int chunks = std::min<size_t>(omp_get_max_threads(), values.size() / min_chunk_size);
+    if (chunks <= 1) {
+        std::sort(values.begin(), values.end(), cmp);
+        return;
+    }
+
+    std::vector<typename std::vector<T>::iterator> bounds(chunks + 1);
+    for (int c=0; c<=chunks; c++) {
+        bounds[c] = values.begin() + values.size() * c / chunks;
+    }
+
+    #pragma omp parallel for
+    for (int c=0; c<chunks; c++) {
+        std::sort(bounds[c], bounds[c+1], cmp);
+    }
+
+    for (int width=1; width<chunks; width*=2) {
+        #pragma omp parallel for
+        for (int c=0; c<chunks-width; c+=2*width) {
+            std::inplace_merge(bounds[c], bounds[c+width], bounds[std::min(c+2*width, chunks)], cmp);
+        }
+    }
+}
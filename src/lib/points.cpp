@@ -1,24 +1,42 @@
 #include <algorithm>
 #include <assert.h>
 #include <iostream>
+#include <limits>
+#include <unordered_map>
 #include <math.h>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "types.hpp"
 #include "random.hpp"
 #include "points.hpp"
 #include "pow_z.hpp"
+#include "timing.hpp"
+#include "tracing.hpp"
+#include "parallel_sort.hpp"
 
-const ll scale = (ll) 1e16;
-
-double solution_cost(const std::vector<tagged_point>& points, const std::vector<point>& facilities, double facility_cost) {
+template<IsPoint T, IsPowZ P>
+double solution_cost(const std::vector<T>& points, const std::vector<point>& facilities, double facility_cost, P pz) {
+    phase_timer timer(CostPhase);
     double cost = facilities.size() * facility_cost;
     std::vector<double> dist(points.size());
+    if (points.empty()) return cost;
 
-    #pragma omp parallel for
-    for (size_t i=0; i<points.size(); i++) {
-        double md = min_dist(points[i], facilities).dist;
-        dist[i] = POWZ(md);
+    int dim = points[0].coords.size();
+    std::vector<double> facility_coords = scaled_coords(dim, facilities);
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("solution_cost");
+        std::vector<double> p(dim);
+        #pragma omp for nowait
+        for (size_t i=0; i<points.size(); i++) {
+            for (int d=0; d<dim; d++) {
+                p[d] = (double) points[i][d] / scale;
+            }
+            dist[i] = weight_of(points[i]) * pz.pow(sqrt(min_dist_squared(dim, p.data(), facility_coords)));
+        }
     }
     
     for (double d: dist) {
@@ -27,19 +45,39 @@ double solution_cost(const std::vector<tagged_point>& points, const std::vector<
     return cost;
 }
 
-double solution_cost(const std::vector<tagged_point>& points, const std::vector<int>& facility_indexes, double facility_cost) {
+template<IsPoint T, IsPowZ P>
+double solution_cost(const std::vector<T>& points, const std::vector<int>& facility_indexes, double facility_cost, P pz) {
     std::vector<point> facilities;
     facilities.reserve(facility_indexes.size());
     for (auto i: facility_indexes)
         facilities.push_back(points[i]);
 
-    return solution_cost(points, facilities, facility_cost);
+    return solution_cost(points, facilities, facility_cost, pz);
 }
 
-double nearest_neighbors(int dim, const std::vector<tagged_point>& points) {
-    const int tries = points.size() / 1e2;
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<point>&, double, pow_z<1>);
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<point>&, double, pow_z<2>);
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<point>&, double, pow_z_real);
+
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<int>&, double, pow_z<1>);
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<int>&, double, pow_z<2>);
+template double solution_cost(const std::vector<tagged_point>&, const std::vector<int>&, double, pow_z_real);
+
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<point>&, double, pow_z<1>);
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<point>&, double, pow_z<2>);
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<point>&, double, pow_z_real);
+
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<int>&, double, pow_z<1>);
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<int>&, double, pow_z<2>);
+template double solution_cost(const std::vector<weighted_point>&, const std::vector<int>&, double, pow_z_real);
+
+template<IsPoint T>
+double nearest_neighbors(int dim, const std::vector<T>& points, int projections) {
+    if (points.size() < 2) return 0;
+
     double result = 0;
-    for (int _=0; _<tries; _++) {
+    std::vector<double> projected(points.size());
+    for (int _=0; _<projections; _++) {
         std::vector<double> projection(dim);
         double norm = 0;
         for (int i=0; i<dim; i++) {
@@ -48,19 +86,21 @@ double nearest_neighbors(int dim, const std::vector<tagged_point>& points) {
         }
         norm = sqrt(norm);
         for (int i=0; i<dim; i++) {
-            projection[i] /= norm;
+            projection[i] /= norm * scale;
         }
 
-        std::vector<double> projected(points.size(), 0);
         #pragma omp parallel for
         for (size_t i=0; i<points.size(); i++) {
+            double value = 0;
             for (int d=0; d<dim; d++) {
-                projected[i] += projection[d] * ((double) points[i][d] / scale);
+                value += projection[d] * points[i][d];
             }
+            projected[i] = value;
         }
-        std::sort(projected.begin(), projected.end());
-        double min_dist = projected[1] - projected[0];
+        parallel_sort(projected);
 
+        double min_dist = projected[1] - projected[0];
+        #pragma omp parallel for reduction(min:min_dist)
         for (size_t i=1; i<points.size(); i++) {
             min_dist = std::min(min_dist, projected[i] - projected[i-1]);
         }
@@ -69,21 +109,134 @@ double nearest_neighbors(int dim, const std::vector<tagged_point>& points) {
     return result;
 }
 
+template double nearest_neighbors(int, const std::vector<tagged_point>&, int);
+template double nearest_neighbors(int, const std::vector<weighted_point>&, int);
+
+/**
+ * @brief Computes minimum non-zero and maximum squared distance over all pairs of points.
+ *
+ * Coordinates are stored dimension-major (coords[d*n + i]), so the innermost loop runs
+ * over a block of consecutive points and vectorizes. Pairs are processed in blocks
+ * that fit into the cache, the blocks are distributed among threads.
+ */
+static std::pair<double, double> pairwise_min_max_squared(int dim, const std::vector<double>& coords, size_t n) {
+    constexpr size_t block = 256;
+    size_t blocks = (n + block - 1) / block;
+
+    double min_d2 = std::numeric_limits<double>::infinity();
+    double max_d2 = 0;
+    #pragma omp parallel for schedule(dynamic) reduction(min:min_d2) reduction(max:max_d2)
+    for (size_t bi=0; bi<blocks; bi++) {
+        double d2[block];
+        for (size_t bj=bi; bj<blocks; bj++) {
+            size_t j_begin = bj * block, j_end = std::min(n, j_begin + block);
+            for (size_t i=bi*block; i<std::min(n, (bi+1)*block); i++) {
+                size_t from = std::max(j_begin, i+1);
+                if (from >= j_end) continue;
+                size_t count = j_end - from;
+
+                for (size_t j=0; j<count; j++) d2[j] = 0;
+                for (int d=0; d<dim; d++) {
+                    const double x = coords[d*n + i];
+                    const double* column = &coords[d*n + from];
+                    #pragma omp simd
+                    for (size_t j=0; j<count; j++) {
+                        double delta = x - column[j];
+                        d2[j] += delta*delta;
+                    }
+                }
+
+                #pragma omp simd reduction(min:min_d2) reduction(max:max_d2)
+                for (size_t j=0; j<count; j++) {
+                    max_d2 = std::max(max_d2, d2[j]);
+                    min_d2 = std::min(min_d2, d2[j] != 0 ? d2[j] : std::numeric_limits<double>::infinity());
+                }
+            }
+        }
+    }
+    return {min_d2, max_d2};
+}
+
+/**
+ * @brief Copies coordinates of the given points in dimension-major order.
+ *        Coordinates stay in scaled units, so squared distances must be divided by scale^2.
+ */
+static std::vector<double> dimension_major_coords(int dim, const std::vector<tagged_point>& points, const std::vector<int>& indexes) {
+    size_t n = indexes.size();
+    std::vector<double> coords(n * dim);
+    #pragma omp parallel for
+    for (size_t i=0; i<n; i++) {
+        for (int d=0; d<dim; d++) {
+            coords[d*n + i] = (double) points[indexes[i]][d];
+        }
+    }
+    return coords;
+}
+
 std::pair<double, double> aspect_ratio(int dim, const std::vector<tagged_point>& points) {
-    double min_d = std::numeric_limits<double>::infinity();  
-    double max_d = 0;  
-    for (size_t i=0; i<points.size(); i++) {
-        for (size_t j=i+1; j<points.size(); j++) {
-            double d = points[i].dist(points[j]);
-            max_d = std::max(max_d, d);
-            if (d != 0) min_d = std::min(min_d, d);
+    std::vector<int> all(points.size());
+    for (size_t i=0; i<points.size(); i++) all[i] = i;
+
+    auto [min_d2, max_d2] = pairwise_min_max_squared(dim, dimension_major_coords(dim, points, all), points.size());
+    assert(min_d2 != 0);
+    double scale2 = (double) scale * scale;
+    return {sqrt(min_d2 / scale2), sqrt(max_d2 / scale2)};
+}
+
+double closest_pair(int dim, const std::vector<tagged_point>& points) {
+    constexpr int max_grid_dimension = 5;
+    size_t n = points.size();
+    if (dim > max_grid_dimension || n < 1000) return aspect_ratio(dim, points).first;
+
+    // Closest pair of a random sample of n^(2/3) points bounds the closest distance from above
+    // and leaves expected O(n) close pairs to check (Rabin's algorithm)
+    std::vector<int> sample(std::min<size_t>(n, ceil(pow(n, 2.0/3.0))));
+    for (int& i: sample) i = randRange<size_t>(0, n-1);
+    double delta = sqrt(pairwise_min_max_squared(dim, dimension_major_coords(dim, points, sample), sample.size()).first / ((double) scale * scale));
+    if (delta == std::numeric_limits<double>::infinity()) return aspect_ratio(dim, points).first;
+
+    // Any pair closer than delta lies in the same or in neighboring cells of side delta
+    ll cell_size = std::clamp<double>(ceil(delta * scale), 1, std::numeric_limits<ll>::max() / 2);
+    auto cell_of = [&](const point& p) {
+        std::vector<ll> cell(dim);
+        for (int d=0; d<dim; d++) {
+            cell[d] = p[d] / cell_size - (p[d] % cell_size < 0);
+        }
+        return cell;
+    };
+    auto cell_hash = [](const std::vector<ll>& cell) {
+        ull hash = 0;
+        for (ll c: cell) hash = (hash ^ (ull) c) * 0x9E3779B97F4A7C15ULL;
+        return (size_t) hash;
+    };
+    std::unordered_map<std::vector<ll>, std::vector<int>, decltype(cell_hash)> cells(n, cell_hash);
+    for (size_t i=0; i<n; i++) {
+        cells[cell_of(points[i])].push_back(i);
+    }
+
+    int neighbors = pow(3, dim);
+    double min_d2 = delta * delta;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(min:min_d2)
+    for (size_t i=0; i<n; i++) {
+        std::vector<ll> cell = cell_of(points[i]), neighbor(dim);
+        for (int offset=0; offset<neighbors; offset++) {
+            for (int d=0, rest=offset; d<dim; d++, rest/=3) {
+                neighbor[d] = cell[d] + rest % 3 - 1;
+            }
+            auto it = cells.find(neighbor);
+            if (it == cells.end()) continue;
+            for (int j: it->second) {
+                if ((size_t) j <= i) continue;
+                double d2 = points[i].dist_squared(points[j]);
+                if (d2 != 0) min_d2 = std::min(min_d2, d2);
+            }
         }
     }
-    assert(min_d != 0);
-    return {min_d, max_d};
+    return sqrt(min_d2);
 }
 
-std::pair<double, double> aspect_ratio_approx(int dim, const std::vector<tagged_point>& points) {
+template<IsPoint T>
+std::pair<double, double> aspect_ratio_approx(int dim, const std::vector<T>& points) {
     point min_coords(dim), max_coords(dim);
     for (int i=0; i<dim; i++) {
         min_coords[i] = std::numeric_limits<ll>::max();
@@ -98,14 +251,73 @@ std::pair<double, double> aspect_ratio_approx(int dim, const std::vector<tagged_
     return {nearest_neighbors(dim, points), min_coords.dist(max_coords)};
 }
 
-std::vector<tagged_point> load_points(int n, int dim) {
+template std::pair<double, double> aspect_ratio_approx(int, const std::vector<tagged_point>&);
+template std::pair<double, double> aspect_ratio_approx(int, const std::vector<weighted_point>&);
+
+std::vector<tagged_point> load_points(int n, int dim, std::istream& in) {
+    phase_timer timer(LoadPhase);
     std::vector<tagged_point> points(n, tagged_point(dim));
     for (int i=0; i<n; i++) {
         for (int j=0; j<dim; j++) {
             double coord;
-            std::cin >> coord;
+            if (!(in >> coord)) {
+                throw std::runtime_error("cannot read point " + std::to_string(i) + " of " + std::to_string(n));
+            }
             points[i].coords[j] = coord * scale;
         }
     }
     return points;
 }
+
+ChunkedPointReader::ChunkedPointReader(std::istream& in, size_t n, int dim, size_t chunk_size)
+    : _in(in), _start(in.tellg()), _size(n), _dimension(dim), _chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+bool ChunkedPointReader::next(std::vector<tagged_point>& chunk) {
+    if (_position >= _size) return false;
+    size_t count = std::min(_chunk_size, _size - _position);
+    chunk = load_points(count, _dimension, _in);
+    _position += count;
+    return true;
+}
+
+void ChunkedPointReader::rewind() {
+    _in.clear();
+    _in.seekg(_start);
+    _position = 0;
+}
+
+std::vector<tagged_point> read_points(ChunkedPointReader& reader, const std::vector<int>& indexes) {
+    std::vector<int> order(indexes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return indexes[a] < indexes[b]; });
+
+    std::vector<tagged_point> points(indexes.size(), tagged_point(reader.dimension()));
+    std::vector<tagged_point> chunk;
+    size_t next = 0;
+    reader.rewind();
+    while (next < order.size()) {
+        size_t begin = reader.position();
+        if (!reader.next(chunk)) {
+            throw std::out_of_range("point " + std::to_string(indexes[order[next]]) + " of " + std::to_string(reader.size()));
+        }
+        for (; next < order.size() && (size_t) indexes[order[next]] < begin + chunk.size(); next++) {
+            points[order[next]] = chunk[indexes[order[next]] - begin];
+        }
+    }
+    return points;
+}
+
+template<IsPowZ P>
+double solution_cost(ChunkedPointReader& reader, const std::vector<point>& facilities, double facility_cost, P pz) {
+    double cost = facilities.size() * facility_cost;
+    std::vector<tagged_point> chunk;
+    reader.rewind();
+    while (reader.next(chunk)) {
+        cost += solution_cost(chunk, facilities, 0, pz);
+    }
+    return cost;
+}
+
+template double solution_cost(ChunkedPointReader&, const std::vector<point>&, double, pow_z<1>);
+template double solution_cost(ChunkedPointReader&, const std::vector<point>&, double, pow_z<2>);
+template double solution_cost(ChunkedPointReader&, const std::vector<point>&, double, pow_z_real);
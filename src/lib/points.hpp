@@ -1,14 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <concepts>
 #include <math.h>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include "types.hpp"
+#include "pow_z.hpp"
 
 /// Global scaling factor for coordinates
-extern const ll scale;
+constexpr ll scale = (ll) 1e16;
 
 /**
  * @brief Represents a point in a multidimensional space.
@@ -51,15 +54,20 @@ struct point {
         return coords[idx];
     }
 
-    double dist_squared(const point& p) const {
+    /// Squared distance in scaled coordinates (i.e. multiplied by scale^2), computed without divisions.
+    double dist_squared_scaled(const point& p) const {
         double result = 0;
         for (int i=0; i<(int) coords.size(); i++) {
-            double delta = (double) coords[i] / scale - (double) p.coords[i] / scale;
+            double delta = (double) coords[i] - (double) p.coords[i];
             result += delta*delta;
         }
         return result;
     }
 
+    double dist_squared(const point& p) const {
+        return dist_squared_scaled(p) / ((double) scale * scale);
+    }
+
     double dist(const point& p) const {
         return sqrt(dist_squared(p));
     }
@@ -98,6 +106,51 @@ struct weighted_point : public tagged_point {
 template <typename T>
 concept IsPoint = std::is_base_of_v<point, T>;
 
+/// Number of points represented by a point (one for points without a weight).
+inline int weight_of(const tagged_point& p) { return 1; }
+/// Number of points represented by a weighted point.
+inline int weight_of(const weighted_point& p) { return p.weight; }
+
+/**
+ * @brief Copies coordinates of points divided by `scale` in row-major order,
+ *        so that distance kernels work on plain doubles.
+ * @param dim The dimension of the space.
+ * @param points The points.
+ * @return Vector of `dim` coordinates for each point.
+ */
+template <IsPoint T>
+std::vector<double> scaled_coords(int dim, const std::vector<T>& points) {
+    std::vector<double> coords(points.size() * dim);
+    for (size_t i=0; i<points.size(); i++) {
+        for (int d=0; d<dim; d++) {
+            coords[i*dim + d] = (double) points[i].coords[d] / scale;
+        }
+    }
+    return coords;
+}
+
+/**
+ * @brief Finds the minimum squared distance from a point to a set of points, both given as plain coordinates.
+ * @param dim The dimension of the space.
+ * @param p The coordinates of the point.
+ * @param coords The coordinates of the set in row-major order (see `scaled_coords`).
+ * @return The minimum squared distance (infinity for an empty set).
+ */
+inline double min_dist_squared(int dim, const double* p, const std::vector<double>& coords) {
+    double min_dist2 = std::numeric_limits<double>::infinity();
+    for (size_t f=0; f*dim<coords.size(); f++) {
+        const double* q = &coords[f*dim];
+        double dist2 = 0;
+        #pragma omp simd reduction(+: dist2)
+        for (int d=0; d<dim; d++) {
+            double delta = p[d] - q[d];
+            dist2 += delta*delta;
+        }
+        min_dist2 = std::min(min_dist2, dist2);
+    }
+    return min_dist2;
+}
+
 /**
  * @brief Represents point and distance to it from some other point.
  */
@@ -129,38 +182,64 @@ dist_pair min_dist(const point& p, const std::vector<T>& points) {
 
 /**
  * @brief Computes the cost of a solution given points and facilities.
+ *        The distance of a weighted point is counted once per point it represents.
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
  * @param points The set of points.
  * @param facilities The built facilities.
  * @param facility_cost Cost per one facility.
+ * @param pz The cost exponent z.
  * @return The total cost of the solution.
  */
-double solution_cost(const std::vector<tagged_point>& points, const std::vector<point>& facilities, double facility_cost);
+template<IsPoint T, IsPowZ P>
+double solution_cost(const std::vector<T>& points, const std::vector<point>& facilities, double facility_cost, P pz);
 
 /**
  * @brief Computes the cost of a solution given points and facilities which are built on top the points.
+ * @tparam T The type of the points (`tagged_point` or `weighted_point`).
  * @param points The set of points.
  * @param facility_indexes Indexes of points on which to build facilities.
  * @param facility_cost Cost per one facility.
+ * @param pz The cost exponent z.
  * @return The total cost of the solution.
  */
-double solution_cost(const std::vector<tagged_point>& points, const std::vector<int>& facility_indexes, double facility_cost);
+template<IsPoint T, IsPowZ P>
+double solution_cost(const std::vector<T>& points, const std::vector<int>& facility_indexes, double facility_cost, P pz);
 
 /**
- * @brief Approximates distance between two closest points using Johnson–Lindenstrauss.
+ * @brief Approximates distance between two closest points using Johnson–Lindenstrauss in O(projections·(nd + nlogn)).
+ *
+ * Points are projected to random lines and the largest of the closest distances on the lines is returned.
+ * The result never overestimates the true distance and more projections make it more accurate.
+ *
  * @param dim The dimension of the space.
  * @param points The set of points.
+ * @param projections The number of random projections.
  * @return The nearest neighbor distance.
  */
-double nearest_neighbors(int dim, const std::vector<tagged_point>& points);
+template<IsPoint T>
+double nearest_neighbors(int dim, const std::vector<T>& points, int projections=16);
 
 /**
- * @brief Computes the minimum and maximum distance of a set of points in O(n^2d).
+ * @brief Computes the minimum (non-zero) and maximum distance of a set of points in O(n^2d).
+ *        Uses a cache-blocked, multithreaded and vectorized kernel over squared distances.
  * @param dim The dimension of the space.
  * @param points The set of points.
  * @return A pair containing the minimum and maximum distances.
  */
 std::pair<double, double> aspect_ratio(int dim, const std::vector<tagged_point>& points);
 
+/**
+ * @brief Computes the minimum (non-zero) distance of a set of points exactly.
+ *
+ * For low dimension uses a grid with cells of side given by the closest pair of a random sample,
+ * which takes expected O(3^d nd) time. Otherwise falls back to the O(n^2d) kernel of `aspect_ratio`.
+ *
+ * @param dim The dimension of the space.
+ * @param points The set of points.
+ * @return The minimum distance between two distinct points.
+ */
+double closest_pair(int dim, const std::vector<tagged_point>& points);
+
 /**
  * @brief Approximates the minimum and maximum of a set of points in time O(nd + nlogn).
  *
@@ -171,12 +250,78 @@ std::pair<double, double> aspect_ratio(int dim, const std::vector<tagged_point>&
  * @param points The set of points.
  * @return A pair containing the approximate minimum and maximum distances.
  */
-std::pair<double, double> aspect_ratio_approx(int dim, const std::vector<tagged_point>& points);
+template<IsPoint T>
+std::pair<double, double> aspect_ratio_approx(int dim, const std::vector<T>& points);
 
 /**
- * @brief Loads a set of points from std::cin.
+ * @brief Loads a set of points from a stream.
  * @param n The number of points to load.
  * @param dim The dimension of the space.
+ * @param in The stream to read from.
  * @return A vector of loaded points.
+ * @throws std::runtime_error If the stream ends or fails before `n` points are read.
+ */
+std::vector<tagged_point> load_points(int n, int dim, std::istream& in = std::cin);
+
+/**
+ * @brief Reads a set of points from a seekable stream one chunk at a time,
+ *        so that the whole set never has to be held in memory.
+ */
+class ChunkedPointReader {
+  private:
+    std::istream& _in;
+    std::istream::pos_type _start;
+    size_t _size;
+    int _dimension;
+    size_t _chunk_size;
+    size_t _position = 0;
+
+  public:
+    /**
+     * @brief Constructs a reader of points starting at the current position of the stream.
+     * @param in The stream to read from, must support seeking.
+     * @param n The number of points in the stream.
+     * @param dim The dimension of the space.
+     * @param chunk_size The maximum number of points in a chunk.
+     */
+    ChunkedPointReader(std::istream& in, size_t n, int dim, size_t chunk_size);
+
+    size_t size() const { return _size; }
+    int dimension() const { return _dimension; }
+
+    /// Index of the first point of the chunk returned by the next call of `next`.
+    size_t position() const { return _position; }
+
+    /**
+     * @brief Reads the next chunk of points.
+     * @param chunk Output vector, replaced by the points of the chunk.
+     * @return `false` if all points were already read, `true` otherwise.
+     * @throws std::runtime_error If the stream ends or fails before the chunk is read (see `load_points`).
+     */
+    bool next(std::vector<tagged_point>& chunk);
+
+    /**
+     * @brief Returns to the first point, to start another pass over the set.
+     */
+    void rewind();
+};
+
+/**
+ * @brief Reads the points with the given indexes in one pass over a reader, which is rewound first.
+ * @param reader The reader of the set of points.
+ * @param indexes Indexes of points in the set.
+ * @return The points in the order of `indexes`.
+ */
+std::vector<tagged_point> read_points(ChunkedPointReader& reader, const std::vector<int>& indexes);
+
+/**
+ * @brief Computes the cost of a solution in one pass over a reader, which is rewound first,
+ *        so that the set of points never has to be held in memory.
+ * @param reader The reader of the set of points.
+ * @param facilities The built facilities.
+ * @param facility_cost Cost per one facility.
+ * @param pz The cost exponent z.
+ * @return The total cost of the solution.
  */
-std::vector<tagged_point> load_points(int n, int dim);
\ No newline at end of file
+template<IsPowZ P>
+double solution_cost(ChunkedPointReader& reader, const std::vector<point>& facilities, double facility_cost, P pz);
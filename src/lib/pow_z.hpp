@@ -1,9 +1,67 @@
-#ifdef Z2
-#define Z 2
-#define POWZ(x) ((x)*(x))
-#define INVPOWZ(x) sqrt(x)
-#else
-#define Z 1
-#define POWZ(x) (x)
-#define INVPOWZ(x) (x)
-#endif
+#pragma once
+
+#include <concepts>
+#include <math.h>
+
+/**
+ * @brief Cost exponent z known at compile time.
+ *        The z power of distance to each point is added to the solution cost.
+ *
+ * Specializations for z=1 and z=2 avoid calls to `pow` in the hot loops.
+ *
+ * @tparam Z The cost exponent.
+ */
+template<int Z>
+struct pow_z {
+    double z() const { return Z; }
+
+    /// Computes x^z.
+    double pow(double x) const {
+        if constexpr (Z == 1) return x;
+        else if constexpr (Z == 2) return x*x;
+        else return ::pow(x, Z);
+    }
+
+    /// Computes x^(1/z).
+    double invpow(double x) const {
+        if constexpr (Z == 1) return x;
+        else if constexpr (Z == 2) return sqrt(x);
+        else return ::pow(x, 1.0 / Z);
+    }
+};
+
+/**
+ * @brief Cost exponent z given at runtime.
+ */
+struct pow_z_real {
+    double exponent; ///< The cost exponent z.
+
+    double z() const { return exponent; }
+
+    /// Computes x^z.
+    double pow(double x) const { return ::pow(x, exponent); }
+
+    /// Computes x^(1/z).
+    double invpow(double x) const { return ::pow(x, 1.0 / exponent); }
+};
+
+template<typename P>
+concept IsPowZ = requires(const P pz, double x) {
+    { pz.z() } -> std::convertible_to<double>;
+    { pz.pow(x) } -> std::convertible_to<double>;
+    { pz.invpow(x) } -> std::convertible_to<double>;
+};
+
+/**
+ * @brief Calls a function with the cost exponent z, using compile time specialization for z=1 and z=2.
+ *
+ * @param z The cost exponent.
+ * @param f The function to call. Must accept pow_z<1>, pow_z<2> and pow_z_real and return the same type for each.
+ * @return The result of f.
+ */
+template<typename F>
+auto dispatch_z(double z, F&& f) {
+    if (z == 1) return f(pow_z<1>());
+    if (z == 2) return f(pow_z<2>());
+    return f(pow_z_real{z});
+}
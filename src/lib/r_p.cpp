@@ -3,18 +3,22 @@
 #include <algorithm>
 
 #include "points.hpp"
+#include "r_p.hpp"
 #include "bin_search.hpp"
 #include "pow_z.hpp"
+#include "timing.hpp"
 
-double calc_rp_first_k(const std::vector<tagged_point>& points, tagged_point from, int k, double facility_cost) {
+template<IsPowZ P>
+double calc_rp_first_k(const std::vector<tagged_point>& points, tagged_point from, int k, double facility_cost, P pz) {
     double sum = facility_cost;
     for (int i=0; i<k; i++) {
-        sum += POWZ(from.dist(points[i]));
+        sum += pz.pow(from.dist(points[i]));
     }
-    return INVPOWZ(sum / k);
+    return pz.invpow(sum / k);
 }
 
-double calc_rp(const std::vector<tagged_point>& points, int from, double facility_cost) {
+template<IsPowZ P>
+double calc_rp(const std::vector<tagged_point>& points, int from, double facility_cost, P pz) {
     std::vector<tagged_point> copied_points(points);
     std::sort(
         copied_points.begin(), copied_points.end(),
@@ -24,23 +28,26 @@ double calc_rp(const std::vector<tagged_point>& points, int from, double facilit
     );
 
     int included = binary_search<int>(
-        [&copied_points, &points, &from, &facility_cost](int mid) {
-            double rp_mid = calc_rp_first_k(copied_points, points[from], mid+1, facility_cost);
+        [&copied_points, &points, &from, &facility_cost, &pz](int mid) {
+            double rp_mid = calc_rp_first_k(copied_points, points[from], mid+1, facility_cost, pz);
             return rp_mid < points[from].dist(copied_points[mid]);
         },
         0, copied_points.size()
     );
 
-    return calc_rp_first_k(copied_points, points[from], included, facility_cost);
+    return calc_rp_first_k(copied_points, points[from], included, facility_cost, pz);
 }
 
-void calc_rps(std::vector<tagged_point>& points, double facility_cost) {
+template<IsPowZ P>
+void calc_rps(std::vector<tagged_point>& points, double facility_cost, P pz) {
+    phase_timer timer(EvalBallPhase);
     for (int i=0; i<(int) points.size(); i++) {
-        points[i].r_p = calc_rp(points, i, facility_cost);
+        points[i].r_p = calc_rp(points, i, facility_cost, pz);
     }
 }
 
 std::vector<int> mettu_plaxton(const std::vector<tagged_point>& original_points) {
+    phase_timer timer(SelectionPhase);
     std::vector<std::pair<int, const tagged_point*>> points(original_points.size());
     for (int i=0; i<(int) original_points.size(); i++) {
         points[i] = {i, &original_points[i]};
@@ -67,3 +74,15 @@ std::vector<int> mettu_plaxton(const std::vector<tagged_point>& original_points)
 
     return chosen;
 }
+
+template double calc_rp_first_k(const std::vector<tagged_point>&, tagged_point, int, double, pow_z<1>);
+template double calc_rp_first_k(const std::vector<tagged_point>&, tagged_point, int, double, pow_z<2>);
+template double calc_rp_first_k(const std::vector<tagged_point>&, tagged_point, int, double, pow_z_real);
+
+template double calc_rp(const std::vector<tagged_point>&, int, double, pow_z<1>);
+template double calc_rp(const std::vector<tagged_point>&, int, double, pow_z<2>);
+template double calc_rp(const std::vector<tagged_point>&, int, double, pow_z_real);
+
+template void calc_rps(std::vector<tagged_point>&, double, pow_z<1>);
+template void calc_rps(std::vector<tagged_point>&, double, pow_z<2>);
+template void calc_rps(std::vector<tagged_point>&, double, pow_z_real);
@@ -1,6 +1,9 @@
+#pragma once
+
 #include <vector>
 
 #include "points.hpp"
+#include "pow_z.hpp"
 
 /**
  * @brief Calculates r_p for a single point if only k closest points existed.
@@ -8,25 +11,31 @@
  * @param from The index of the point into `points` for which to calculate r_p.
  * @param k How many closest points to consider
  * @param facility_cost The cost per one opened facility.
+ * @param pz The cost exponent z.
  * @return r_p of the given point if only k closest points existed
  */
-double calc_rp_first_k(const std::vector<tagged_point>& points, tagged_point from, int k, double facility_cost);
+template<IsPowZ P>
+double calc_rp_first_k(const std::vector<tagged_point>& points, tagged_point from, int k, double facility_cost, P pz);
 
 /**
  * @brief Calculates r_p for a single point in O(nlogn).
  * @param points The set of points.
  * @param from The index of the point into `points` for which to calculate r_p.
  * @param facility_cost The cost per one opened facility.
+ * @param pz The cost exponent z.
  * @return r_p of the given point
  */
-double calc_rp(const std::vector<tagged_point>& points, int from, double facility_cost);
+template<IsPowZ P>
+double calc_rp(const std::vector<tagged_point>& points, int from, double facility_cost, P pz);
 
 /**
  * @brief Calculates r_p for all points in O(n^2logn).
  * @param points The set of points. (This vector is modified -- r_p is set in every element!)
  * @param facility_cost The cost per one opened facility.
+ * @param pz The cost exponent z.
  */
-void calc_rps(std::vector<tagged_point>& points, double facility_cost);
+template<IsPowZ P>
+void calc_rps(std::vector<tagged_point>& points, double facility_cost, P pz);
 
 /**
  * @brief Mettu-Plaxton algorithm for facility location.
@@ -1,20 +1,45 @@
+#include <atomic>
+#include <limits>
 #include <random>
+#include <omp.h>
 
 #include "types.hpp"
 #include "random.hpp"
 
-std::mt19937 rng(76901);
+static std::atomic<ull> global_seed = 76901;
+// Incremented by every seed, so that each thread derives its generator again on its next draw
+static std::atomic<ull> generation = 0;
+
+std::mt19937& rng() {
+    thread_local std::mt19937 generator;
+    thread_local ull seeded_generation = std::numeric_limits<ull>::max();
+    ull current = generation.load(std::memory_order_acquire);
+    if (seeded_generation != current) {
+        seeded_generation = current;
+        ull value = global_seed.load(std::memory_order_relaxed);
+        int thread = omp_get_thread_num();
+        if (thread != 0) {
+            // splitmix64 of the seed and the thread number
+            value += (ull) thread * 0x9E3779B97F4A7C15ULL;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            value ^= value >> 31;
+        }
+        generator.seed(value);
+    }
+    return generator;
+}
 
 void seed(ull seed) {
-    rng = std::mt19937(seed);
+    global_seed.store(seed, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
 }
 
 double randDouble(double from, double to) {
     std::uniform_real_distribution<double> dist(from, to);
-    return dist(rng);
+    return dist(rng());
 }
 
 bool randBool(double p = 0.5) {
     return randDouble(0, 1) <= p;
 }
-
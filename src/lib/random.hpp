@@ -4,14 +4,31 @@
 
 #include "types.hpp"
 
-extern std::mt19937 rng;
+/**
+ * @brief Random number generator of the calling thread.
+ *
+ * Each thread has its own, derived from the last global seed and the number of the thread in its OpenMP team,
+ * so workers of a parallel region draw different numbers that depend on the seed.
+ * The generator of thread 0 starts from the seed itself.
+ */
+std::mt19937& rng();
 
 /**
- * @brief Initialize the random number generator.
+ * @brief Initialize the random number generators of all threads, call it outside of parallel regions.
  * @param seed The initialization seed
  */
 void seed(ull seed);
 
+/// Seeds the generator of the calling thread for the lifetime of the guard, restoring the previous state afterwards.
+class thread_seed_guard {
+    std::mt19937 _previous;
+public:
+    explicit thread_seed_guard(ull seed) : _previous(rng()) {
+        rng().seed(seed);
+    }
+    ~thread_seed_guard() { rng() = _previous; }
+};
+
 /**
  * @brief Generates random integer from [min, max] inclusive
  * @param min The lower bound (inclusive)
@@ -20,7 +37,7 @@ void seed(ull seed);
  */
 template<typename T> T randRange(T min, T max) {
     std::uniform_int_distribution<T> dist(min, max);
-    return dist(rng);
+    return dist(rng());
 }
 
 /**
@@ -31,7 +48,7 @@ template<typename T> T randRange(T min, T max) {
  */
 template<typename T> T randNormal(T mean, T stddev) {
     std::normal_distribution<double> dist((double) mean, (double) stddev);
-    return (T) dist(rng);
+    return (T) dist(rng());
 }
 
 /**
@@ -0,0 +1,23 @@
+#include <omp.h>
+
+#include "timing.hpp"
+
+const char* const phase_names[PHASE_COUNT] = {"load", "hash", "aggregate", "eval_ball", "selection", "cost"};
+
+double phase_times[PHASE_COUNT] = {0};
+
+void reset_phase_times() {
+    for (int i=0; i<PHASE_COUNT; i++) {
+        phase_times[i] = 0;
+    }
+}
+
+phase_timer::phase_timer(Phase phase) : _phase(phase), _active(!omp_in_parallel()) {
+    if (_active) _start = std::chrono::steady_clock::now();
+}
+
+phase_timer::~phase_timer() {
+    if (!_active) return;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _start;
+    phase_times[_phase] += elapsed.count();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * @brief Phases of the algorithms for which the wall-clock time is accumulated.
+ */
+enum Phase {LoadPhase, HashPhase, AggregatePhase, EvalBallPhase, SelectionPhase, CostPhase, PHASE_COUNT};
+
+/// Names of the phases (in the order of the `Phase` enum).
+extern const char* const phase_names[PHASE_COUNT];
+
+/// Accumulated wall-clock time of every phase in seconds.
+extern double phase_times[PHASE_COUNT];
+
+/**
+ * @brief Sets accumulated times of all phases to zero.
+ */
+void reset_phase_times();
+
+/**
+ * @brief Adds the wall-clock time of its lifetime to a phase.
+ *
+ * Only timers started outside of parallel regions are accounted, so phases evaluated
+ * concurrently by several threads are not counted multiple times.
+ */
+class phase_timer {
+  private:
+    Phase _phase;
+    bool _active;
+    std::chrono::steady_clock::time_point _start;
+  public:
+    phase_timer(Phase phase);
+    ~phase_timer();
+};
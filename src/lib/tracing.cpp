@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include "tracing.hpp"
+
+namespace tracing {
+    struct event {
+        const char* name;
+        std::chrono::steady_clock::time_point start, end;
+    };
+
+    static const std::chrono::steady_clock::time_point trace_start = std::chrono::steady_clock::now();
+
+    // Buffers are allocated once per thread and never freed, so they can be written at exit
+    // even if their threads have already finished. Index of the buffer is used as the thread id.
+    static std::mutex buffers_mutex;
+    static std::vector<std::vector<event>*>* buffers = new std::vector<std::vector<event>*>();
+    static thread_local std::vector<event>* thread_buffer = NULL;
+
+    static void write_trace() {
+        std::ofstream out(getenv("TRACE_OUTPUT"));
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        std::string sep = "";
+        for (size_t thread=0; thread<buffers->size(); thread++) {
+            for (const event& e: *(*buffers)[thread]) {
+                auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(e.start - trace_start).count();
+                auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(e.end - e.start).count();
+                out << sep << "\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread
+                    << ", \"ts\": " << ts / 1e3 << ", \"dur\": " << dur / 1e3 << "}";
+                sep = ",";
+            }
+        }
+        out << "\n]}" << std::endl;
+    }
+
+    static bool init() {
+        if (getenv("TRACE_OUTPUT") == NULL) return false;
+        atexit(write_trace);
+        return true;
+    }
+
+    const bool enabled = init();
+
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        if (thread_buffer == NULL) {
+            thread_buffer = new std::vector<event>();
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers->push_back(thread_buffer);
+        }
+        thread_buffer->push_back({name, start, end});
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * Optional timeline tracing of parallel regions.
+ *
+ * Tracing is enabled by setting the `TRACE_OUTPUT` environment variable to a file path.
+ * Every thread records its events into its own buffer (no locking on record) and
+ * all events are written at exit in the Chrome trace format, which can be opened
+ * in chrome://tracing or https://ui.perfetto.dev.
+ */
+namespace tracing {
+
+    /// Whether tracing is enabled (`TRACE_OUTPUT` is set).
+    extern const bool enabled;
+
+    /**
+     * @brief Records a single event.
+     * @param name The name of the event. Must be a string literal (only the pointer is stored).
+     * @param start The start of the event.
+     * @param end The end of the event.
+     */
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /**
+     * @brief Records an event spanning its lifetime on the current thread.
+     */
+    class scope {
+      private:
+        const char* _name;
+        std::chrono::steady_clock::time_point _start;
+      public:
+        scope(const char* name) : _name(name) {
+            if (enabled) _start = std::chrono::steady_clock::now();
+        }
+        ~scope() {
+            if (enabled) record(_name, _start, std::chrono::steady_clock::now());
+        }
+    };
+}
+
+/// Records the rest of the enclosing scope as an event on the current thread.
+#define TRACE_SCOPE(name) tracing::scope _trace_scope(name)
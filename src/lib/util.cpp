@@ -1,7 +1,113 @@
+#include <cstring>
+#include <math.h>
 #include <iostream>
+#include <string>
+
+#include "util.hpp"
+#include "dimension_reduction.hpp"
+#include "hashing.hpp"
 
 [[noreturn]]
 void invalid_usage_solver() {
-    std::cerr << "Usage: ./facility_set {face_hashing, grid_hashing} [seed]" << std::endl;
+    std::cerr << "Usage: ./facility_set {face_hashing, grid_hashing, lsh_hashing, lattice_hashing} [seed] [--z Z] [--jl EPS] [--jl-dim D] [--stream CHUNK]"
+              << " [--exact-buckets] [--lsh-tables L] [--lsh-projections M] [--bucket-cache MB]" << std::endl;
+    exit(2);
+}
+
+/**
+ * @brief Parses and removes all occurrences of an option with a real value, the last one wins.
+ * @param invalid_usage Called if the value is missing or invalid.
+ */
+static double parse_real_option(int& argc, char const* argv[], const char* option, double value, bool (*valid)(double), void (*invalid_usage)()) {
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], option) != 0) continue;
+        if (i+1 >= argc) invalid_usage();
+        try {
+            value = std::stod(argv[i+1]);
+        } catch (const std::exception&) {
+            invalid_usage();
+        }
+        if (!valid(value)) invalid_usage();
+
+        for (int j=i; j+2<argc; j++) {
+            argv[j] = argv[j+2];
+        }
+        argc -= 2;
+        i--;
+    }
+    return value;
+}
+
+double parse_z(int& argc, char const* argv[]) {
+    return parse_real_option(argc, argv, "--z", 1, [](double z) { return z >= 1; }, invalid_usage_z);
+}
+
+double parse_jl(int& argc, char const* argv[]) {
+    return parse_real_option(argc, argv, "--jl", 0, [](double epsilon) { return 0 < epsilon && epsilon < 1; }, invalid_usage_jl);
+}
+
+int parse_jl_dim(int& argc, char const* argv[]) {
+    return parse_real_option(argc, argv, "--jl-dim", 0, [](double d) { return d >= 1 && d == floor(d); }, invalid_usage_jl);
+}
+
+void report_skipped_reduction(size_t n, int dim, double jl_epsilon, int jl_dim) {
+    int target_dim = jl_target_dimension(n, jl_epsilon, jl_dim);
+    if (target_dim > 0 && target_dim >= dim) {
+        std::cerr << "Dimension reduction skipped: target dimension " << target_dim << " is not below " << dim << std::endl;
+    }
+}
+
+size_t parse_stream(int& argc, char const* argv[]) {
+    return parse_real_option(argc, argv, "--stream", 0, [](double c) { return c >= 1 && c == floor(c); }, invalid_usage_solver);
+}
+
+bool parse_flag(int& argc, char const* argv[], const char* flag) {
+    bool present = false;
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], flag) != 0) continue;
+        present = true;
+        for (int j=i; j+1<argc; j++) {
+            argv[j] = argv[j+1];
+        }
+        argc--;
+        i--;
+    }
+    return present;
+}
+
+std::string parse_hashing_options(int& argc, char const* argv[]) {
+    auto positive_integer = [](double x) { return x >= 1 && x == floor(x); };
+    std::string options = "";
+    if (parse_flag(argc, argv, "--exact-buckets")) {
+        bucket_identity = CellBucketIdentity;
+        options += " --exact-buckets";
+    }
+    double cache_megabytes = parse_real_option(argc, argv, "--bucket-cache", -1, [](double x) { return x >= 0; }, invalid_usage_solver);
+    if (cache_megabytes >= 0) {
+        bucket_cache_budget = cache_megabytes * (1 << 20);
+        options += " --bucket-cache " + std::to_string((size_t) cache_megabytes);
+    }
+    LSHParameters defaults;
+    lsh_parameters.tables = parse_real_option(argc, argv, "--lsh-tables", defaults.tables, positive_integer, invalid_usage_solver);
+    lsh_parameters.projections = parse_real_option(argc, argv, "--lsh-projections", defaults.projections, positive_integer, invalid_usage_solver);
+    if (lsh_parameters.tables != defaults.tables) {
+        options += " --lsh-tables " + std::to_string(lsh_parameters.tables);
+    }
+    if (lsh_parameters.projections != defaults.projections) {
+        options += " --lsh-projections " + std::to_string(lsh_parameters.projections);
+    }
+    return options;
+}
+
+[[noreturn]]
+void invalid_usage_z() {
+    std::cerr << "The cost exponent must be given as `--z Z` for real Z ≥ 1" << std::endl;
+    exit(2);
+}
+
+[[noreturn]]
+void invalid_usage_jl() {
+    std::cerr << "The distortion of dimension reduction must be given as `--jl EPS` for real 0 < EPS < 1"
+              << " and its target dimension as `--jl-dim D` for integer D ≥ 1" << std::endl;
     exit(2);
 }
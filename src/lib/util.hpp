@@ -1,5 +1,84 @@
+#pragma once
+
+#include <string>
+
 /**
  * @brief Reports that the command line arguments were invalid and exits the program.
  */
 [[noreturn]]
 void invalid_usage_solver();
+
+/**
+ * @brief Reports that the cost exponent given on the command line was invalid and exits the program.
+ */
+[[noreturn]]
+void invalid_usage_z();
+
+/**
+ * @brief Reports that the distortion of dimension reduction given on the command line was invalid and exits the program.
+ */
+[[noreturn]]
+void invalid_usage_jl();
+
+/**
+ * @brief Parses and removes the `--z Z` option from the command line arguments.
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (the option and its value are removed).
+ * @return The cost exponent z (1 if the option is not present).
+ */
+double parse_z(int& argc, char const* argv[]);
+
+/**
+ * @brief Parses and removes the `--jl EPS` option from the command line arguments.
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (the option and its value are removed).
+ * @return The distortion ε of the Johnson–Lindenstrauss projection (0, i.e. no projection, if the option is not present).
+ */
+double parse_jl(int& argc, char const* argv[]);
+
+/**
+ * @brief Parses and removes the `--jl-dim D` option from the command line arguments.
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (the option and its value are removed).
+ * @return The target dimension D of the Johnson–Lindenstrauss projection (0, i.e. given by `--jl EPS`, if the option is not present).
+ */
+int parse_jl_dim(int& argc, char const* argv[]);
+
+/**
+ * @brief Reports on stderr that the dimension reduction of `--jl EPS` / `--jl-dim D` is skipped for n points, if it is
+ *        (see `reduce_dimension`).
+ * @param n The number of points.
+ * @param dim The dimension of the space.
+ * @param jl_epsilon The distortion given by `--jl EPS`.
+ * @param jl_dim The target dimension given by `--jl-dim D`.
+ */
+void report_skipped_reduction(size_t n, int dim, double jl_epsilon, int jl_dim);
+
+/**
+ * @brief Parses and removes the `--stream CHUNK` option from the command line arguments.
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (the option and its value are removed).
+ * @return The number of points per chunk read from the input (0, i.e. the input is loaded at once, if the option is not present).
+ */
+size_t parse_stream(int& argc, char const* argv[]);
+
+/**
+ * @brief Parses and removes a flag without a value from the command line arguments.
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (all occurrences of the flag are removed).
+ * @param flag The flag, e.g. `--exact-buckets`.
+ * @return Whether the flag was present.
+ */
+bool parse_flag(int& argc, char const* argv[], const char* flag);
+
+/**
+ * @brief Parses the options shared by the hashing-based solvers and applies them globally.
+ *
+ * - `--exact-buckets` identifies buckets by their cells instead of hashes
+ * - `--lsh-tables L` and `--lsh-projections M` set the parameters of `lsh_hashing`
+ * - `--bucket-cache MB` sets the memory budget of the bucket tables cached by clustering (0 disables the cache)
+ * @param argc The number of arguments (decreased by the number of removed arguments).
+ * @param argv The arguments (the parsed options are removed).
+ * @return The parsed options that differ from the defaults, each preceded by a space.
+ */
+std::string parse_hashing_options(int& argc, char const* argv[]);
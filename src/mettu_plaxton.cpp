@@ -5,13 +5,15 @@
 #include "lib/random.hpp"
 #include "lib/hashing.hpp"
 #include "lib/r_p.hpp"
+#include "lib/util.hpp"
 
 int main(int argc, char const *argv[]) {
+    double z = parse_z(argc, argv);
     int n, dim; double facility_cost;
     std::cin >> n >> dim >> facility_cost;
     auto points = load_points(n, dim);
 
-    calc_rps(points, facility_cost);
+    dispatch_z(z, [&](auto pz) { calc_rps(points, facility_cost, pz); });
 
     auto chosen = mettu_plaxton(points);
     std::cout << std::setprecision(15);
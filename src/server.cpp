@@ -0,0 +1,296 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "lib/hashing.hpp"
+#include "lib/bucket_cache.hpp"
+#include "lib/points.hpp"
+#include "lib/pow_z.hpp"
+#include "lib/util.hpp"
+#include "lib/r_p.hpp"
+#include "lib/random.hpp"
+#include "lib/clustering.hpp"
+#include "lib/facility_set.hpp"
+
+[[noreturn]]
+void invalid_usage_server() {
+    std::cerr << "Usage: ./server <socket> [--exact-buckets] [--lsh-tables L] [--lsh-projections M] [--bucket-cache MB]" << std::endl;
+    exit(2);
+}
+
+/// A set of points loaded once and shared by all requests naming it.
+struct dataset {
+    int dim;
+    std::vector<tagged_point> points;
+    std::optional<std::pair<double, double>> aspect_ratio; ///< Computed by the first clustering request
+    std::unique_ptr<BucketTableCache<int>> cache;          ///< Ball sizes of clustering requests, NULL if disabled
+};
+
+/// Loaded datasets by their id.
+std::map<std::string, dataset> datasets;
+
+/// Like `choose_hashing_scheme`, but reports an unknown name to the client instead of exiting.
+HashingSchemeChoice parse_hashing_scheme(const std::string& name) {
+    for (const char* known: {"face_hashing", "grid_hashing", "lsh_hashing", "lattice_hashing"}) {
+        if (name == known) return choose_hashing_scheme(name);
+    }
+    throw std::invalid_argument("unknown hashing scheme " + name);
+}
+
+/// Parses a whole token as a number, so that trailing characters are an error rather than the next argument.
+double parse_number(const std::string& token, const std::string& what) {
+    size_t end = 0;
+    double value = 0;
+    try {
+        value = std::stod(token, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != token.size() || std::isnan(value)) throw std::invalid_argument(what + " is not a number: " + token);
+    return value;
+}
+
+/// Parses a number of clusters, which must be an integer between 1 and the number of points.
+int parse_k(const std::string& token, const dataset& data) {
+    double k = parse_number(token, "k");
+    // Compared before the cast, which is undefined outside the range of int
+    if (!(k >= 1 && k <= (double) data.points.size())) throw std::invalid_argument("k must be between 1 and the number of points " + std::to_string(data.points.size()));
+    if (k != floor(k)) throw std::invalid_argument("k must be an integer");
+    return (int) k;
+}
+
+/// Parses the optional cost exponent z that ends a request, 1 if it is absent.
+double parse_optional_z(std::istringstream& request) {
+    std::string token, extra;
+    if (!(request >> token)) return 1;
+    if (request >> extra) throw std::invalid_argument("unexpected argument " + extra);
+    double z = parse_number(token, "z");
+    if (!(z >= 1 && std::isfinite(z))) throw std::invalid_argument("z must be at least 1");
+    return z;
+}
+
+/**
+ * Checks that a dataset can be clustered, which needs two points at different positions,
+ * and computes its aspect ratio on the first clustering request.
+ */
+void check_clustering(dataset& data) {
+    if (!data.aspect_ratio) data.aspect_ratio = aspect_ratio_approx(data.dim, data.points);
+    if (data.aspect_ratio->second == 0) throw std::invalid_argument("clustering needs points at two different positions");
+}
+
+/**
+ * `load <dataset> <path>`: reads an input file (in the format of the solvers) into a dataset.
+ */
+std::string load(std::istringstream& request) {
+    std::string id, path;
+    if (!(request >> id >> path)) throw std::invalid_argument("usage: load <dataset> <path>");
+    std::ifstream in(path);
+    int n, dim; double k_or_cost;
+    if (!(in >> n >> dim >> k_or_cost)) throw std::invalid_argument("cannot read " + path);
+    if (n < 1 || dim < 1) throw std::invalid_argument("the number of points and the dimension must be at least 1");
+
+    // A dataset replaces the one of the same id only once it is read in full
+    dataset loaded;
+    loaded.dim = dim;
+    loaded.points = load_points(n, dim, in);
+    if (bucket_cache_budget > 0 && bucket_identity == HashBucketIdentity) {
+        loaded.cache = std::make_unique<BucketTableCache<int>>(bucket_cache_budget);
+    }
+    datasets[id] = std::move(loaded);
+    return std::to_string(n) + " " + std::to_string(dim);
+}
+
+/**
+ * `solve <dataset> {mettu_plaxton, facility_set, clustering} <k or facility cost> [<hashing scheme> <seed>] [z]`:
+ * runs a solver and gives its cost, time and chosen points.
+ */
+std::string solve(std::istringstream& request) {
+    std::string id, solution, k_or_cost_token;
+    if (!(request >> id >> solution >> k_or_cost_token)) throw std::invalid_argument("usage: solve <dataset> <solution> <k or facility cost> [<hashing scheme> <seed>] [z]");
+    auto it = datasets.find(id);
+    if (it == datasets.end()) throw std::invalid_argument("unknown dataset " + id);
+    dataset& data = it->second;
+    if (solution != "mettu_plaxton" && solution != "facility_set" && solution != "clustering") throw std::invalid_argument("unknown solution " + solution);
+
+    HashingSchemeChoice hs_choice = FaceHashingScheme;
+    ull seed_value = 0;
+    if (solution != "mettu_plaxton") {
+        std::string scheme, seed_hex;
+        if (!(request >> scheme >> seed_hex)) throw std::invalid_argument("missing hashing scheme and seed");
+        hs_choice = parse_hashing_scheme(scheme);
+        seed_value = std::stoull(seed_hex, NULL, 16);
+    }
+    double z = parse_optional_z(request);
+    double k_or_cost;
+    if (solution == "clustering") {
+        k_or_cost = parse_k(k_or_cost_token, data);
+        check_clustering(data);
+    } else {
+        k_or_cost = parse_number(k_or_cost_token, "the facility cost");
+        if (!(k_or_cost > 0 && std::isfinite(k_or_cost))) throw std::invalid_argument("the facility cost must be positive");
+    }
+    seed(seed_value);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> chosen = dispatch_z(z, [&](auto pz) {
+        if (solution == "mettu_plaxton") {
+            std::vector<tagged_point> rp_points(data.points);
+            calc_rps(rp_points, k_or_cost, pz);
+            return mettu_plaxton(rp_points);
+        } else if (solution == "facility_set") {
+            return compute_facilities(data.dim, data.points, k_or_cost, hs_choice, pz);
+        } else {
+            return compute_clusters_seq(data.dim, data.points, (int) k_or_cost, hs_choice, pz, *data.aspect_ratio, data.cache.get());
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double facility_cost = solution == "clustering" ? 0.0 : k_or_cost;
+    double cost = dispatch_z(z, [&](auto pz) { return solution_cost(data.points, chosen, facility_cost, pz); });
+    std::ostringstream response;
+    response << std::fixed << std::setprecision(4) << cost << std::defaultfloat << " " << elapsed.count() << " " << chosen.size();
+    for (int c: chosen) {
+        response << " " << c;
+    }
+    return response.str();
+}
+
+/**
+ * `sweep <dataset> <k1,k2,...> <hashing scheme> <seed> [z]`: clusters for every k at once (see `compute_clusters_multi_k`),
+ * gives the time, then the cost and chosen points of each k, separated by `;`.
+ */
+std::string sweep(std::istringstream& request) {
+    std::string id, ks_list, scheme, seed_hex;
+    if (!(request >> id >> ks_list >> scheme >> seed_hex)) throw std::invalid_argument("usage: sweep <dataset> <k1,k2,...> <hashing scheme> <seed> [z]");
+    auto it = datasets.find(id);
+    if (it == datasets.end()) throw std::invalid_argument("unknown dataset " + id);
+    dataset& data = it->second;
+
+    std::vector<int> ks;
+    std::istringstream ks_stream(ks_list);
+    for (std::string k; std::getline(ks_stream, k, ','); ) {
+        ks.push_back(parse_k(k, data));
+    }
+    if (ks.empty()) throw std::invalid_argument("missing k");
+    HashingSchemeChoice hs_choice = parse_hashing_scheme(scheme);
+    ull seed_value = std::stoull(seed_hex, NULL, 16);
+    double z = parse_optional_z(request);
+    check_clustering(data);
+
+    seed(seed_value);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<clustering_solution> solutions = dispatch_z(z, [&](auto pz) {
+        return compute_clusters_multi_k(data.dim, data.points, ks, hs_choice, pz, *data.aspect_ratio, data.cache.get());
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::ostringstream response;
+    response << elapsed.count();
+    for (size_t i=0; i<solutions.size(); i++) {
+        response << (i == 0 ? " " : " ; ") << solutions[i].k << " " << std::fixed << std::setprecision(4) << solutions[i].cost << std::defaultfloat << " " << solutions[i].centers.size();
+        for (int c: solutions[i].centers) {
+            response << " " << c;
+        }
+    }
+    return response.str();
+}
+
+/**
+ * Answers a single request line, `ok <result>` or `error <message>`.
+ * @param stop Set when the request asks the server to stop.
+ */
+std::string respond(const std::string& line, bool& stop) {
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+    try {
+        if (command == "load") {
+            return "ok " + load(request);
+        } else if (command == "solve") {
+            return "ok " + solve(request);
+        } else if (command == "sweep") {
+            return "ok " + sweep(request);
+        } else if (command == "unload") {
+            std::string id;
+            request >> id;
+            if (datasets.erase(id) == 0) throw std::invalid_argument("unknown dataset " + id);
+            return "ok";
+        } else if (command == "shutdown") {
+            stop = true;
+            return "ok";
+        }
+        throw std::invalid_argument("unknown command " + command);
+    } catch (const std::exception& e) {
+        return std::string("error ") + e.what();
+    }
+}
+
+/**
+ * Serves the requests of a single connection, one per line, until the client closes it.
+ * @return Whether a request asked the server to stop.
+ */
+bool serve(int connection) {
+    std::string buffer;
+    char chunk[4096];
+    bool stop = false;
+    ssize_t received;
+    while (!stop && (received = recv(connection, chunk, sizeof(chunk), 0)) > 0) {
+        buffer.append(chunk, received);
+        size_t end;
+        while (!stop && (end = buffer.find('\n')) != std::string::npos) {
+            std::string response = respond(buffer.substr(0, end), stop) + "\n";
+            buffer.erase(0, end + 1);
+            for (size_t sent = 0; sent < response.size(); ) {
+                ssize_t written = send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (written <= 0) return stop;
+                sent += written;
+            }
+        }
+    }
+    return stop;
+}
+
+/**
+ * Keeps datasets in memory and answers requests on a Unix domain socket, so that many queries
+ * against the same points pay for loading them (and for their aspect ratio) only once.
+ * Clustering requests with the same seed also share the ball sizes of their hashing schemes.
+ * Connections are served one at a time, each request runs with all threads.
+ */
+int main(int argc, char const *argv[]) {
+    parse_hashing_options(argc, argv);
+    if (argc != 2) invalid_usage_server();
+    std::string path = argv[1];
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) invalid_usage_server();
+    path.copy(address.sun_path, path.size());
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (server < 0 || bind(server, (sockaddr*) &address, sizeof(address)) < 0 || listen(server, 16) < 0) {
+        perror("server");
+        return 1;
+    }
+
+    bool stop = false;
+    while (!stop) {
+        int connection = accept(server, NULL, NULL);
+        if (connection < 0) continue;
+        stop = serve(connection);
+        close(connection);
+    }
+    close(server);
+    unlink(path.c_str());
+}
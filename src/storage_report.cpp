@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/hashing.hpp"
+#include "lib/points.hpp"
+#include "lib/compact_points.hpp"
+#include "lib/pow_z.hpp"
+#include "lib/util.hpp"
+#include "lib/clustering.hpp"
+#include "lib/facility_set.hpp"
+
+[[noreturn]]
+void invalid_usage_storage_report() {
+    std::cerr << "Usage: ./storage_report {fl,cl} <input> {face_hashing, grid_hashing, lsh_hashing, lattice_hashing} seed [--z Z]" << std::endl;
+    exit(2);
+}
+
+/**
+ * Runs the solver on the input stored in each coordinate storage and compares the costs
+ * (evaluated on the original coordinates) to the cost obtained with `ll` coordinates.
+ */
+int main(int argc, char const *argv[]) {
+    double z = parse_z(argc, argv);
+    if (argc != 5) invalid_usage_storage_report();
+    std::string target = argv[1], input = argv[2];
+    if (target != "fl" && target != "cl") invalid_usage_storage_report();
+    HashingSchemeChoice hs_choice = choose_hashing_scheme(argv[3]);
+    ull seed_value = strtoull(argv[4], 0, 16);
+
+    std::ifstream in(input);
+    if (!in) invalid_usage_storage_report();
+    int n, dim; double k_or_cost;
+    in >> n >> dim >> k_or_cost;
+    auto points = load_points(n, dim, in);
+    double facility_cost = target == "fl" ? k_or_cost : 0.0;
+
+    std::cout << "storage,bytes,max_coord_error,cost_stored,cost,relative_difference,time" << std::endl;
+    double reference_cost = 0;
+    for (CoordinateStorage storage: {Int64Storage, Float32Storage, Int32Storage, Int16Storage}) {
+        CompactPoints compact(dim, points, storage);
+        std::vector<tagged_point> stored_points = compact.decode();
+
+        double max_error = 0;
+        std::vector<double> coords(dim);
+        for (int i=0; i<n; i++) {
+            compact.decode(i, coords.data());
+            for (int d=0; d<dim; d++) {
+                max_error = std::max(max_error, std::abs(coords[d] - (double) points[i][d] / scale));
+            }
+        }
+
+        seed(seed_value);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int> chosen = dispatch_z(z, [&](auto pz) {
+            if (target == "fl") return compute_facilities(dim, stored_points, k_or_cost, hs_choice, pz);
+            else                return compute_clusters_seq(dim, stored_points, (int) k_or_cost, hs_choice, pz);
+        });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<point> facilities;
+        for (int c: chosen) facilities.push_back(points[c]);
+        double cost_stored = dispatch_z(z, [&](auto pz) { return solution_cost(compact, facilities, facility_cost, pz); });
+        double cost = dispatch_z(z, [&](auto pz) { return solution_cost(points, facilities, facility_cost, pz); });
+        if (storage == Int64Storage) reference_cost = cost;
+
+        std::cout << coordinate_storage_name(storage) << "," << compact.bytes() << "," << max_error << ","
+                  << std::fixed << std::setprecision(4) << cost_stored << "," << cost << std::defaultfloat << std::setprecision(6)
+                  << "," << (cost - reference_cost) / reference_cost << "," << elapsed.count() << std::endl;
+    }
+}
@@ -8,29 +8,36 @@ import time
 parser = argparse.ArgumentParser(prog='test', description='Script for testing facility set / clustering solution')
 parser.add_argument("target", choices=["fl", "cl"])
 parser.add_argument("z", type=int, choices=[1, 2])
+parser.add_argument("--threads", help="comma separated thread counts to sweep (default: all cores)")
+parser.add_argument("--repeat", type=int, default=3, help="timed repetitions of each solution")
 args = parser.parse_args()
 
 Z = args.z
+args_threads = args.threads
+args_repeat = args.repeat
 
 BUILD_DIR = "build"
 DATA_DIR = "data"
 GEN_DATA_DIR = "gen"
-GENERATOR = f"data_gen_z{Z}"
+GENERATOR = "data_gen"
+DRIVER = "driver"
 
-FACILITY_JUDGE = f"facility_set_cost_z{Z}"
-FACILITY_SOLUTIONS = [f"mettu_plaxton_z{Z}"] + [f"facility_set_z{Z}"]*2
+FACILITY_JUDGE = "facility_set_cost"
+FACILITY_SOLUTIONS = [f"mettu_plaxton_z{Z}"] + [f"facility_set_z{Z}"]*3
 FACILITY_SOLUTION_ARGS = [
     [],
     ["grid_hashing", "60042651f648e052"],
     ["face_hashing", "60042651f648e052"],
+    ["lattice_hashing", "60042651f648e052"],
 ]
 FACILITY_COST = 1
 
-CLUSTERING_JUDGE = f"clustering_cost_z{Z}"
-CLUSTERING_SOLUTIONS = [f"scikit_z{Z}"]*(2 if Z == 1 else 1) + [f"clustering_z{Z}"]*2
+CLUSTERING_JUDGE = "clustering_cost"
+CLUSTERING_SOLUTIONS = [f"scikit_z{Z}"]*(2 if Z == 1 else 1) + [f"clustering_z{Z}"]*3
 CLUSTERING_SOLUTION_ARGS = ([["alternate"], ["pam"]] if Z == 1 else [[""]]) + [
     ["grid_hashing",  "60042651f648e052"],
     ["face_hashing",  "60042651f648e052"],
+    ["lattice_hashing", "60042651f648e052"],
 ]
 
 SIZES = [100, 500, 1000, 5000, int(1e4), int(5e4), int(1e5), int(5e5), int(1e6)]
@@ -96,9 +103,21 @@ def solve(input_path: str, solution: str, args: list[str]) -> tuple[str, float]:
     return output_path, total_time
 
 
+def drive(target: str, input_path: str, solution: str, args: list[str]) -> list[list[str]]:
+    """Runs a solution in-process via the driver, which times only the algorithm itself."""
+    output_path = input_path.removesuffix(".in") + f".{solution}.{'.'.join(args)}.out"
+    driver_args = [target, input_path, solution.removesuffix(f"_z{Z}"), *args, "--z", str(Z), "--repeat", str(args_repeat), "--output", output_path]
+    if args_threads is not None:
+        driver_args += ["--threads", args_threads]
+    process = Popen([os.path.join(BUILD_DIR, DRIVER), *driver_args], stdout=PIPE)
+    rows = list(csv.reader(process.communicate()[0].decode().strip().split("\n")))
+    assert process.returncode == 0
+    return rows
+
+
 def judge(judge: str, input_path: str, output_path: str) -> float:
     process = Popen(
-        [os.path.join(BUILD_DIR, judge)],
+        [os.path.join(BUILD_DIR, judge), "--z", str(Z)],
         stdin=open(input_path),
         stdout=PIPE,
         env={"SOLUTION" : output_path}
@@ -108,16 +127,22 @@ def judge(judge: str, input_path: str, output_path: str) -> float:
 
 def test_facility_location(inp: str):
     for solution, args in zip(FACILITY_SOLUTIONS, FACILITY_SOLUTION_ARGS, strict=True):
-        print(f"{os.path.basename(inp):20} {solution:20} {' '.join(args):30}", end="  ", flush=True)
-        out, sol_time = solve(inp, solution, args)
-        result = f"{judge(FACILITY_JUDGE, inp, out):.4f}"
-        print(f"{result:>10}  {sol_time:.2f}s")
-        results.writerow((os.path.basename(inp), solution, " ".join(args), result, sol_time))
+        for row in drive("fl", inp, solution, args):
+            result, sol_time = row[3], float(row[4])
+            print(f"{os.path.basename(inp):20} {solution:20} {' '.join(args):30}  {result:>10}  {sol_time:.2f}s  {row[5]} threads")
+            results.writerow(row)
     print("-"*50)
 
 
 def test_clustering(inp: str):
     for solution, args in zip(CLUSTERING_SOLUTIONS, CLUSTERING_SOLUTION_ARGS, strict=True):
+        if not solution.startswith("scikit"):
+            for row in drive("cl", inp, solution, args):
+                centers, result, sol_time = int(row[3]), row[4], float(row[5])
+                print(f"{os.path.basename(inp):20} {solution:20} {' '.join(args):30}  {centers:>3}  {result:>10}  {sol_time:.2f}s  {row[6]} threads")
+                results.writerow(row)
+            continue
+
         print(f"{os.path.basename(inp):20} {solution:20} {' '.join(args):30}", end="  ", flush=True)
         out, sol_time = solve(inp, solution, args)
         with open(out) as f:
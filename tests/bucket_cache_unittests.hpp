@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+#include "../src/lib/bucket_cache.hpp"
+#include "../src/lib/facility_set.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(BucketCache, SeededSchemesHashAlike) {
+    seed(3);
+    int dim = 3;
+    std::vector<tagged_point> points(200, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 5) * scale;
+    }
+
+    for (HashingSchemeChoice hs_choice: {GridHashingScheme, FaceHashingScheme, LSHHashingScheme, LatticeHashingScheme}) {
+        std::mt19937 before = rng();
+        auto sizes = make_hashing_scheme<int>(hs_choice, dim, 0.5, 42);
+        auto labels = make_hashing_scheme<const tagged_point*>(hs_choice, dim, 0.5, 42);
+        auto other = make_hashing_scheme<int>(hs_choice, dim, 0.5, 43);
+        ASSERT_TRUE(rng() == before);
+
+        int differing = 0;
+        for (const auto& p: points) {
+            ASSERT_EQ(sizes->hash(p), labels->hash(p));
+            differing += sizes->hash(p) != other->hash(p);
+        }
+        ASSERT_GT(differing, 0);
+    }
+}
+
+TEST(BucketCache, ServesRepeatedRadii) {
+    seed(5);
+    int dim = 2;
+    std::vector<tagged_point> points(500, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 5) * scale;
+    }
+
+    BucketTableCache<int> cache(1 << 30);
+    auto computed = cached_ball_sizes(dim, points, 0.5, Composable::Size, GridHashingScheme, 7, cache);
+    auto served = cached_ball_sizes(dim, points, 0.5, Composable::Size, GridHashingScheme, 7, cache);
+    ASSERT_EQ(computed, served);
+    ASSERT_EQ(cache.size(), 1);
+    for (size_t i=0; i<points.size(); i++) {
+        ASSERT_EQ(points[i].hash, computed->hashes[i]);
+        int inner_count = 0;
+        for (const auto& q: points) inner_count += points[i].dist(q) <= 0.5;
+        ASSERT_GE(computed->ball_sizes[i], inner_count);
+    }
+
+    cached_ball_sizes(dim, points, 0.5, Composable::Size, GridHashingScheme, 8, cache);
+    cached_ball_sizes(dim, points, 0.5, Composable::Size, FaceHashingScheme, 7, cache);
+    ASSERT_EQ(cache.size(), 3);
+}
+
+TEST(BucketCache, KeepsSmallestRadiiOfScheme) {
+    seed(7);
+    int dim = 2;
+    std::vector<tagged_point> points(500, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 5) * scale;
+    }
+
+    BucketTableCache<int> unbounded(1 << 30);
+    size_t entry_bytes = cached_ball_sizes(dim, points, 1.0, Composable::Size, GridHashingScheme, 1, unbounded)->bytes();
+    BucketTableCache<int> cache(2 * entry_bytes + entry_bytes / 2);
+    for (int pass=0; pass<2; pass++) {
+        for (double radius: {1.0, 2.0, 4.0}) {
+            cached_ball_sizes(dim, points, radius, Composable::Size, GridHashingScheme, 1, cache);
+        }
+    }
+    ASSERT_EQ(cache.hits(), 2);
+    ASSERT_EQ(cache.misses(), 4);
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_LE(cache.bytes(), 2 * entry_bytes + entry_bytes / 2);
+    ASSERT_EQ(cache.find(GridHashingScheme, 1, 4.0), nullptr);
+
+    // Another seed evicts the least recently used entries of the first one
+    ASSERT_NE(cache.find(GridHashingScheme, 1, 1.0), nullptr);
+    cached_ball_sizes(dim, points, 1.0, Composable::Size, GridHashingScheme, 2, cache);
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_NE(cache.find(GridHashingScheme, 2, 1.0), nullptr);
+    ASSERT_NE(cache.find(GridHashingScheme, 1, 1.0), nullptr);
+    ASSERT_EQ(cache.find(GridHashingScheme, 1, 2.0), nullptr);
+}
+
+TEST(BucketCache, FacilitySetsOfSeveralCosts) {
+    int dim = 2, n = 400;
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    seed(9);
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 5) * scale;
+    }
+    std::vector<double> facility_costs = {0.5, 2.0, 8.0, 32.0};
+
+    BucketTableCache<int> unbounded(1 << 30);
+    std::vector<std::vector<int>> expected;
+    seed(10);
+    for (double facility_cost: facility_costs) {
+        expected.push_back(compute_facilities(dim, points, facility_cost, GridHashingScheme, pow_z<1>(), unbounded, 3));
+    }
+    size_t radii = unbounded.size();
+
+    size_t entry_bytes = cached_ball_sizes(dim, points, 1.0, Composable::Size, GridHashingScheme, 1, unbounded)->bytes();
+    size_t fitting = 8;
+    ASSERT_LT(fitting, radii);
+    BucketTableCache<int> cache(fitting * entry_bytes + entry_bytes / 2);
+    seed(10);
+    for (size_t i=0; i<facility_costs.size(); i++) {
+        std::vector<int> facilities = compute_facilities(dim, points, facility_costs[i], GridHashingScheme, pow_z<1>(), cache, 3);
+        ASSERT_EQ(facilities, expected[i]);
+        ASSERT_FALSE(facilities.empty());
+        ASSERT_TRUE(std::is_sorted(facilities.begin(), facilities.end()));
+        ASSERT_GE(facilities.front(), 0);
+        ASSERT_LT(facilities.back(), n);
+    }
+    // Every facility set after the first is served the smallest radii
+    ASSERT_EQ(cache.size(), fitting);
+    ASSERT_GE(cache.hits(), (facility_costs.size() - 1) * fitting);
+    ASSERT_LE(cache.bytes(), fitting * entry_bytes + entry_bytes / 2);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+
+#include "../src/lib/bucket_table.hpp"
+#include "../src/lib/eval_composable.hpp"
+#include "../src/lib/random.hpp"
+#include "test_utils.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(BucketTable, CollidingHashes) {
+    int dim = 3;
+    std::vector<ull> cells = {1, 2, 3, 1, 2, 4, 7, 0, 3};
+
+    BucketTable<int> by_hash(3);
+    BucketTable<int> by_cell(dim, cells);
+    for (int c=0; c<3; c++) {
+        by_hash.get_or_insert(42, &cells[c * dim], 0)++;
+        by_cell.get_or_insert(42, &cells[c * dim], 0)++;
+    }
+    ASSERT_EQ(by_hash.size(), 1);
+    ASSERT_EQ(*by_hash.find(42, &cells[0]), 3);
+
+    ASSERT_EQ(by_cell.size(), 3);
+    for (int c=0; c<3; c++) {
+        ASSERT_EQ(*by_cell.find(42, &cells[c * dim]), 1);
+    }
+    std::vector<ull> missing = {1, 2, 5}, outside = {8, 0, 3};
+    ASSERT_EQ(by_cell.find(42, missing.data()), nullptr);
+    ASSERT_EQ(by_cell.find(42, outside.data()), nullptr);
+}
+
+TEST(BucketSet, CollidingHashes) {
+    int dim = 3;
+    std::vector<ull> cells = {1, 2, 3, 1, 2, 4, 1, 2, 3};
+
+    BucketSet by_hash(false, dim);
+    BucketSet by_cell(true, dim);
+    std::vector<bool> hash_inserted, cell_inserted;
+    for (int c=0; c<3; c++) {
+        hash_inserted.push_back(by_hash.insert(42, &cells[c * dim]));
+        cell_inserted.push_back(by_cell.insert(42, &cells[c * dim]));
+    }
+    ASSERT_EQ(hash_inserted, std::vector<bool>({true, false, false}));
+    ASSERT_EQ(by_hash.size(), 1);
+    ASSERT_EQ(cell_inserted, std::vector<bool>({true, true, false}));
+    ASSERT_EQ(by_cell.size(), 2);
+}
+
+TEST(CellPacking, FieldWidth) {
+    std::vector<std::pair<ull, int>> extents = {{0, 8}, {255, 8}, {256, 16}, {65536, 32}, {1ULL << 40, 64}};
+    for (auto [extent, bits]: extents) {
+        ull base = std::numeric_limits<ull>::max() - extent;
+        std::vector<ull> cells = {base, 5, base + extent, 7};
+        CellPacking packing(2, cells);
+        ASSERT_EQ(packing.bits(), bits);
+        ASSERT_EQ(packing.words(), (2 * bits + 63) / 64);
+
+        std::vector<ull> key(packing.words());
+        for (int c=0; c<2; c++) {
+            packing.pack(&cells[c * 2], key.data());
+            ASSERT_TRUE(packing.matches(key.data(), &cells[c * 2]));
+            ASSERT_FALSE(packing.matches(key.data(), &cells[(1 - c) * 2]));
+        }
+    }
+}
+
+TEST(BucketTable, EvalComposableIdentitiesAgree) {
+    int dim = 3;
+    std::vector<tagged_point> points;
+    for (int i=0; i<2000; i++) {
+        point p({randDouble(0, 10), randDouble(0, 10), randDouble(0, 10)});
+        points.emplace_back(dim);
+        points.back().coords = p.coords;
+    }
+
+    for (HashingSchemeChoice hs_choice: {GridHashingScheme, FaceHashingScheme}) {
+        seed(1);
+        auto by_hash = eval_composable(dim, points, 0.5, Composable::Size, hs_choice);
+        std::vector<int> by_cell;
+        {
+            bucket_identity_guard guard(CellBucketIdentity);
+            seed(1);
+            by_cell = eval_composable(dim, points, 0.5, Composable::Size, hs_choice);
+        }
+        ASSERT_EQ(by_hash, by_cell);
+    }
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include <omp.h>
+
+#include "../src/lib/clustering.hpp"
+#include "../src/lib/random.hpp"
+#include "test_utils.hpp"
+
+#include "gtest/gtest.h"
+
+/// Reads the points in chunks of `chunk_size` for `merge_reduce_coreset`.
+static std::function<bool(std::vector<weighted_point>&)> chunks_of(const std::vector<weighted_point>& points, size_t chunk_size) {
+    auto position = std::make_shared<size_t>(0);
+    return [&points, chunk_size, position](std::vector<weighted_point>& chunk) {
+        if (*position >= points.size()) return false;
+        size_t end = std::min(points.size(), *position + chunk_size);
+        chunk.assign(points.begin() + *position, points.begin() + end);
+        *position = end;
+        return true;
+    };
+}
+
+TEST(Clustering, MergeReduceCoresetKeepsWeight) {
+    seed(13);
+    int dim = 2, k = 4, n = 2000;
+    std::vector<weighted_point> points;
+    ll total_weight = 0;
+    for (const tagged_point& p: clustered_points(dim, n, k)) {
+        points.emplace_back(p);
+        points.back().weight = randRange(1, 5);
+        total_weight += points.back().weight;
+    }
+
+    for (size_t chunk_size: {150, 5000}) {
+        auto root = merge_reduce_coreset(dim, chunks_of(points, chunk_size), k, GridHashingScheme, pow_z<1>());
+        ASSERT_LT(root.size(), n);
+        std::set<int> indexes;
+        ll weight = 0;
+        for (const auto& [i, p]: root) {
+            ASSERT_GE(i, 0);
+            ASSERT_LT(i, n);
+            ASSERT_TRUE(indexes.insert(i).second);
+            ASSERT_EQ(p, points[i]);
+            weight += p.weight;
+        }
+        ASSERT_EQ(weight, total_weight);
+    }
+}
+
+TEST(Clustering, MergeReduceIndependentOfThreads) {
+    seed(13);
+    int dim = 2, k = 4, n = 2000;
+    std::vector<weighted_point> points;
+    for (const tagged_point& p: clustered_points(dim, n, k)) {
+        points.emplace_back(p);
+        points.back().weight = 1;
+    }
+
+    // Leaves are seeded in advance, so neither the number of threads nor the order they run in changes the result
+    int max_threads = omp_get_max_threads();
+    std::vector<std::vector<int>> results;
+    for (int threads: {1, 4, 4}) {
+        omp_set_num_threads(threads);
+        seed(41);
+        results.push_back(compute_clusters_merge_reduce(dim, points, k, GridHashingScheme, pow_z<1>(), 150));
+    }
+    omp_set_num_threads(max_threads);
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(results[1], results[2]);
+    EXPECT_TRUE(opens_every_cluster(points, results[0], k));
+}
+
+TEST(Clustering, WeightsCountAsCopies) {
+    seed(17);
+    int dim = 2, n = 300;
+    std::vector<weighted_point> points;
+    for (const tagged_point& p: clustered_points(dim, n, 1)) {
+        points.emplace_back(p);
+        points.back().weight = 1;
+    }
+    std::vector<tagged_point> unweighted(points.begin(), points.end());
+
+    // Unit weights give the same result as the points themselves
+    seed(43);
+    auto expected = compute_clusters_seq(dim, unweighted, 3, GridHashingScheme, pow_z<2>());
+    seed(43);
+    ASSERT_EQ(compute_clusters_seq(dim, points, 3, GridHashingScheme, pow_z<2>()), expected);
+
+    // A single center goes to a far point only if it weighs more than the others together
+    points.emplace_back(dim);
+    points.back()[0] = cluster_distance * scale;
+    for (int weight: {1, 1000}) {
+        points.back().weight = weight;
+        std::vector<int> chosen = compute_clusters_seq(dim, points, 1, GridHashingScheme, pow_z<2>());
+        ASSERT_EQ(chosen.size(), 1);
+        ASSERT_EQ(chosen[0] == n, weight > n);
+    }
+}
+
+TEST(Clustering, IncrementalCoresetCountsNearestPoints) {
+    seed(19);
+    int dim = 2, k = 3, n = 900;
+    std::vector<tagged_point> points = clustered_points(dim, n, k);
+
+    // The third cluster appears only in the inserted batches
+    std::vector<tagged_point> initial, inserted;
+    for (int i=0; i<n; i++) {
+        (i % k == 2 ? inserted : initial).push_back(points[i]);
+    }
+    IncrementalClustering<pow_z<2>> clustering(dim, initial, k, GridHashingScheme, pow_z<2>());
+    for (size_t begin=0; begin<=inserted.size(); begin+=100) {
+        if (begin == inserted.size()) {
+            clustering.expire(100);
+        } else {
+            clustering.insert(std::vector<tagged_point>(inserted.begin() + begin, inserted.begin() + std::min(inserted.size(), begin + 100)));
+        }
+
+        // Every point counts towards its nearest facility
+        std::vector<int> facilities = clustering.facilities();
+        ASSERT_FALSE(facilities.empty());
+        std::vector<int> nearest_counts(clustering.size(), 0);
+        for (const tagged_point& p: clustering.points()) {
+            int nearest = facilities[0];
+            for (int f: facilities) {
+                if (p.dist(clustering.points()[f]) < p.dist(clustering.points()[nearest])) nearest = f;
+            }
+            nearest_counts[nearest]++;
+        }
+        auto coreset = clustering.coreset();
+        ASSERT_EQ(coreset.size(), facilities.size());
+        for (size_t c=0; c<coreset.size(); c++) {
+            ASSERT_EQ(coreset[c].first, facilities[c]);
+            ASSERT_EQ(coreset[c].second, clustering.points()[facilities[c]]);
+            ASSERT_EQ(coreset[c].second.weight, nearest_counts[facilities[c]]);
+        }
+    }
+    ASSERT_EQ(clustering.size(), n - 100);
+    ASSERT_TRUE(opens_every_cluster(clustering.points(), clustering.centers(), k));
+}
+
+TEST(Clustering, SlidingWindowForgetsExpiredClusters) {
+    seed(23);
+    int dim = 2, k = 2, n = 300;
+    std::vector<std::vector<tagged_point>> clusters(3);
+    for (const tagged_point& p: clustered_points(dim, 3 * n, 3)) {
+        clusters[cluster_of(p)].push_back(p);
+    }
+
+    // The window moves from clusters 0 and 1 to clusters 1 and 2
+    std::vector<tagged_point> initial = clusters[0], first = clusters[1], last = clusters[2];
+    initial.insert(initial.end(), first.begin(), first.end());
+    IncrementalClustering<pow_z<1>> clustering(dim, initial, k, GridHashingScheme, pow_z<1>());
+    for (int begin=0; begin<n; begin+=100) {
+        clustering.insert(std::vector<tagged_point>(last.begin() + begin, last.begin() + begin + 100));
+        clustering.expire(100);
+    }
+    ASSERT_EQ(clustering.size(), 2 * n);
+    for (int i=0; i<n; i++) {
+        ASSERT_EQ(clustering.points()[i], first[i]);
+    }
+
+    std::set<int> opened;
+    for (int c: clustering.centers()) {
+        ASSERT_GE(c, 0);
+        ASSERT_LT(c, 2 * n);
+        opened.insert(cluster_of(clustering.points()[c]));
+    }
+    ASSERT_EQ(opened, std::set<int>({1, 2}));
+}
+
+TEST(Clustering, IncrementalLevelsFollowSpread) {
+    seed(29);
+    int dim = 2, k = 10, n = 5000;
+    std::vector<tagged_point> initial(n, tagged_point(dim)), far(100, tagged_point(dim));
+    for (auto& p: initial) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 10) * scale;
+    }
+    for (auto& p: far) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(100, 101) * scale;
+    }
+
+    // The radius guesses stop at the diameter of the points, and grow with it
+    IncrementalClustering<pow_z<1>> clustering(dim, initial, k, GridHashingScheme, pow_z<1>());
+    clustering.insert(far);
+    clustering.expire(far.size());
+    bool far_opened = false;
+    for (int c: clustering.centers()) {
+        ASSERT_GE(c, 0);
+        ASSERT_LT(c, n);
+        far_opened |= clustering.points()[c][0] >= 100 * scale;
+    }
+    ASSERT_TRUE(far_opened);
+}
+
+TEST(Clustering, MultiKMatchesSingleK) {
+    seed(29);
+    int dim = 3, n = 500;
+    std::vector<tagged_point> points;
+    for (int i=0; i<n; i++) {
+        points.emplace_back(dim);
+        for (int d=0; d<dim; d++) {
+            points.back()[d] = randDouble(0, 1) * scale;
+        }
+    }
+
+    for (int k: {1, 5, 20}) {
+        seed(31);
+        auto expected = compute_clusters_seq(dim, points, k, FaceHashingScheme, pow_z<2>());
+        seed(31);
+        auto solutions = compute_clusters_multi_k(dim, points, {k}, FaceHashingScheme, pow_z<2>());
+        ASSERT_EQ(solutions.size(), 1);
+        ASSERT_EQ(solutions[0].k, k);
+        ASSERT_EQ(solutions[0].centers, expected);
+        ASSERT_DOUBLE_EQ(solutions[0].cost, solution_cost(points, expected, 0, pow_z<2>()));
+    }
+}
+
+TEST(Clustering, MultiKCostDecreasesWithK) {
+    seed(37);
+    int dim = 2, clusters = 8, n = 800;
+    std::vector<tagged_point> points = clustered_points(dim, n, clusters);
+
+    std::vector<int> ks = {8, 2, 4, 1};
+    auto solutions = compute_clusters_multi_k(dim, points, ks, GridHashingScheme, pow_z<2>());
+    ASSERT_EQ(solutions.size(), ks.size());
+    std::map<int, double> costs;
+    for (size_t i=0; i<ks.size(); i++) {
+        ASSERT_EQ(solutions[i].k, ks[i]);
+        ASSERT_FALSE(solutions[i].centers.empty());
+        ASSERT_LT(solutions[i].centers.size(), 1.1 * ks[i]);
+        ASSERT_DOUBLE_EQ(solutions[i].cost, solution_cost(points, solutions[i].centers, 0, pow_z<2>()));
+        costs[ks[i]] = solutions[i].cost;
+    }
+    for (auto it = std::next(costs.begin()); it != costs.end(); it++) {
+        ASSERT_LT(it->second, std::prev(it)->second);
+    }
+}
+
+TEST(Clustering, FewPoints) {
+    int dim = 2;
+    for (int n=2; n<=7; n++) {
+        for (ull s=0; s<20; s++) {
+            seed(s);
+            std::vector<tagged_point> points;
+            for (int i=0; i<n; i++) {
+                points.emplace_back(dim);
+                points.back()[0] = randRange(0, 2) * scale;
+                points.back()[1] = randRange(0, 1) * 3 * scale;
+            }
+            // At least two positions
+            points[1][0] = points[0][0] + scale;
+            std::vector<int> ks;
+            for (int k=1; k<=n; k++) ks.push_back(k);
+            for (HashingSchemeChoice hs_choice: {GridHashingScheme, LatticeHashingScheme}) {
+                for (const clustering_solution& solution: compute_clusters_multi_k(dim, points, ks, hs_choice, pow_z<1>())) {
+                    ASSERT_FALSE(solution.centers.empty());
+                    for (int c: solution.centers) {
+                        ASSERT_GE(c, 0);
+                        ASSERT_LT(c, n);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <sstream>
+#include <vector>
+
+#include "../src/lib/compact_points.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+static std::vector<tagged_point> random_tagged_points(int n, int dim, double from, double to) {
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) {
+            p[d] = randDouble(from, to) * scale;
+        }
+    }
+    return points;
+}
+
+TEST(CompactPoints, QuantizationError) {
+    int dim = 4;
+    auto points = random_tagged_points(1000, dim, -30, 70);
+
+    for (auto [storage, bytes, max_error]: std::vector<std::tuple<CoordinateStorage, size_t, double>>{
+            {Int64Storage, 8, 1e-12}, {Float32Storage, 4, 1e-5}, {Int32Storage, 4, 1e-7}, {Int16Storage, 2, 100.0 / 65535}}) {
+        CompactPoints compact(dim, points, storage);
+        ASSERT_EQ(compact.bytes(), bytes * points.size() * dim);
+
+        std::vector<double> coords(dim);
+        for (size_t i=0; i<points.size(); i++) {
+            compact.decode(i, coords.data());
+            for (int d=0; d<dim; d++) {
+                ASSERT_NEAR(coords[d], (double) points[i][d] / scale, max_error);
+            }
+        }
+    }
+}
+
+TEST(CompactPoints, SolutionCostMatchesDecoded) {
+    int dim = 3;
+    auto points = random_tagged_points(500, dim, 0, 10);
+    std::vector<point> facilities(points.begin(), points.begin() + 5);
+
+    for (CoordinateStorage storage: {Int64Storage, Float32Storage, Int32Storage, Int16Storage}) {
+        CompactPoints compact(dim, points, storage);
+        double expected = solution_cost(compact.decode(), facilities, 1.0, pow_z<2>{});
+        ASSERT_NEAR(solution_cost(compact, facilities, 1.0, pow_z<2>{}), expected, 1e-9 * expected);
+    }
+}
+
+TEST(CompactPoints, LoadRoundsToStorage) {
+    int dim = 2;
+    std::string input = "1.5 -2.25\n3.125 7\n-4 0.5\n";
+    for (CoordinateStorage storage: {Int64Storage, Float32Storage, Int32Storage, Int16Storage}) {
+        std::istringstream in64(input), in(input);
+        auto points = load_points(3, dim, in64);
+        auto stored = load_points(3, dim, storage, in);
+        ASSERT_EQ(stored, CompactPoints(dim, points, storage).decode());
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+
+#include "../src/lib/dimension_reduction.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(DimensionReduction, PreservesDistances) {
+    seed(7);
+    int n = 100, dim = 1000;
+    double epsilon = 0.5;
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) {
+            p[d] = randDouble(0, 1) * scale;
+        }
+    }
+
+    int target_dim = jl_dimension(n, epsilon);
+    ASSERT_LT(target_dim, dim);
+    auto projected = jl_project(dim, points, target_dim, epsilon);
+    ASSERT_EQ(projected.size(), points.size());
+    ASSERT_EQ((int) projected[0].coords.size(), target_dim);
+
+    for (int i=0; i<n; i++) {
+        for (int j=i+1; j<n; j++) {
+            double ratio = projected[i].dist(projected[j]) / points[i].dist(points[j]);
+            ASSERT_GT(ratio, 1 - epsilon);
+            ASSERT_LT(ratio, 1 + epsilon);
+        }
+    }
+}
+
+TEST(DimensionReduction, SkipsLowDimension) {
+    int dim = 3;
+    std::vector<tagged_point> points(50, tagged_point(dim));
+    auto reduced = reduce_dimension(dim, points, 0.5);
+    ASSERT_EQ(dim, 3);
+    ASSERT_EQ(reduced.size(), points.size());
+
+    // The binaries report a skipped reduction from the target dimension
+    ASSERT_EQ(jl_target_dimension(points.size(), 0.5, 0), jl_dimension(points.size(), 0.5));
+    ASSERT_GE(jl_target_dimension(points.size(), 0.5, 0), dim);
+    ASSERT_EQ(jl_target_dimension(points.size(), 0.5, 2), 2);
+    ASSERT_EQ(jl_target_dimension(points.size(), 0, 0), 0);
+}
+
+TEST(DimensionReduction, ExplicitTargetDimension) {
+    seed(11);
+    int n = 20000, dim = 40;
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) {
+            p[d] = randDouble(0, 1) * scale;
+        }
+    }
+
+    // The JL dimension for any ε < 1 exceeds the dimension, so only an explicit target projects
+    int reduced_dim = dim;
+    reduce_dimension(reduced_dim, points, 0.9);
+    ASSERT_EQ(reduced_dim, dim);
+
+    auto reduced = reduce_dimension(reduced_dim, points, 0, 16);
+    ASSERT_EQ(reduced_dim, 16);
+    ASSERT_EQ(reduced.size(), points.size());
+    ASSERT_EQ((int) reduced[0].coords.size(), 16);
+    ASSERT_NEAR(jl_distortion(n, jl_dimension(n, 0.5)), 0.5, 0.01);
+}
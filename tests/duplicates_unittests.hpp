@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+
+#include "../src/lib/duplicates.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(Duplicates, CollapsesExactCopies) {
+    int dim = 2;
+    std::vector<tagged_point> distinct;
+    for (int i=0; i<50; i++) {
+        distinct.emplace_back(dim);
+        distinct.back()[0] = randRange(0, 5) * scale;
+        distinct.back()[1] = i;
+    }
+    std::vector<tagged_point> points;
+    std::vector<int> copies(distinct.size(), 0);
+    for (int i=0; i<1000; i++) {
+        int j = randRange(0, (int) distinct.size() - 1);
+        points.push_back(distinct[j]);
+        copies[j]++;
+    }
+
+    unique_points unique = collapse_duplicates(dim, points);
+    int total_weight = 0;
+    for (size_t u=0; u<unique.points.size(); u++) {
+        int original = unique.original_indexes[u];
+        ASSERT_EQ(unique.points[u], points[original]);
+        if (u > 0) {
+            ASSERT_LT(unique.original_indexes[u-1], original);
+        }
+        for (int i=0; i<original; i++) {
+            ASSERT_NE(points[i], points[original]);
+        }
+        ASSERT_EQ(unique.points[u].weight, copies[unique.points[u][1]]);
+        total_weight += unique.points[u].weight;
+    }
+    ASSERT_EQ(total_weight, (int) points.size());
+    ASSERT_EQ(unique.to_original({0, 1}), std::vector<int>({unique.original_indexes[0], unique.original_indexes[1]}));
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "../src/lib/eval_composable.hpp"
+#include "../src/lib/facility_set.hpp"
+#include "../src/lib/random.hpp"
+#include "test_utils.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(FacilitySet, StreamingIndependentOfChunks) {
+    seed(11);
+    int dim = 3, n = 600;
+    std::vector<tagged_point> points = clustered_points(dim, n, 2);
+    std::ostringstream text;
+    text << std::setprecision(17);
+    for (const tagged_point& p: points) {
+        for (int d=0; d<dim; d++) {
+            text << (double) p[d] / scale << (d+1 < dim ? " " : "\n");
+        }
+    }
+
+    // Labels come from the indexes of points and facilities are drawn in their order, so chunks do not matter
+    std::vector<std::vector<int>> results;
+    for (size_t chunk_size: {1, 7, 1000}) {
+        std::stringstream input(text.str());
+        ChunkedPointReader reader(input, n, dim, chunk_size);
+        seed(47);
+        results.push_back(compute_facilities_streaming(reader, 1.0, GridHashingScheme, pow_z<1>()));
+    }
+    ASSERT_FALSE(results[0].empty());
+    ASSERT_TRUE(std::is_sorted(results[0].begin(), results[0].end()));
+    ASSERT_GE(results[0].front(), 0);
+    ASSERT_LT(results[0].back(), n);
+    ASSERT_EQ(results[0], results[1]);
+    ASSERT_EQ(results[0], results[2]);
+}
+
+TEST(FacilitySet, WeightedBallSizesMatchDuplicates) {
+    int dim = 3;
+    std::vector<weighted_point> points;
+    std::vector<tagged_point> duplicated;
+    std::vector<int> first_copy;
+    for (int i=0; i<500; i++) {
+        point p({randDouble(0, 10), randDouble(0, 10), randDouble(0, 10)});
+        points.emplace_back(dim);
+        points.back().coords = p.coords;
+        points.back().weight = randRange(1, 5);
+        first_copy.push_back(duplicated.size());
+        for (int w=0; w<points.back().weight; w++) {
+            duplicated.push_back(points.back());
+        }
+    }
+
+    for (HashingSchemeChoice hs_choice: {GridHashingScheme, FaceHashingScheme}) {
+        seed(3);
+        std::vector<ll> weighted_sizes = eval_composable(dim, points, 1.0, Composable::WeightedSize, hs_choice);
+        seed(3);
+        std::vector<int> sizes = eval_composable(dim, duplicated, 1.0, Composable::Size, hs_choice);
+        for (size_t i=0; i<points.size(); i++) {
+            ASSERT_EQ(weighted_sizes[i], sizes[first_copy[i]]);
+        }
+        // Points without a weight count once
+        seed(3);
+        std::vector<ll> unweighted_sizes = eval_composable(dim, duplicated, 1.0, Composable::WeightedSize, hs_choice);
+        ASSERT_EQ(unweighted_sizes, std::vector<ll>(sizes.begin(), sizes.end()));
+    }
+}
+
+TEST(FacilitySet, UnitWeightsMatchPoints) {
+    seed(5);
+    int dim = 2, n = 300;
+    std::vector<tagged_point> points = clustered_points(dim, n, 2);
+    std::vector<weighted_point> weighted(points.begin(), points.end());
+    for (weighted_point& p: weighted) {
+        p.weight = 1;
+    }
+
+    for (HashingSchemeChoice hs_choice: {GridHashingScheme, FaceHashingScheme}) {
+        seed(53);
+        std::vector<int> expected = compute_facilities(dim, points, 1.0, hs_choice, pow_z<1>());
+        seed(53);
+        ASSERT_EQ(compute_facilities(dim, weighted, 1.0, hs_choice, pow_z<1>()), expected);
+    }
+}
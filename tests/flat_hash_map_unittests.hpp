@@ -0,0 +1,40 @@
+#pragma once
+#include <unordered_map>
+
+#include "../src/lib/flat_hash_map.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(FlatHashMap, MatchesUnorderedMap) {
+    FlatHashMap<int> table;
+    std::unordered_map<ull, int> expected;
+    for (int i=0; i<10000; i++) {
+        ull key = randRange<ull>(0, 5000);
+        table.get_or_insert(key, 0) += i;
+        expected[key] += i;
+    }
+    ASSERT_EQ(table.size(), expected.size());
+    for (ull key=0; key<=6000; key++) {
+        const int* value = table.find(key);
+        if (expected.count(key)) {
+            ASSERT_NE(value, nullptr);
+            ASSERT_EQ(*value, expected[key]);
+        } else {
+            ASSERT_EQ(value, nullptr);
+        }
+    }
+}
+
+TEST(FlatHashMap, FindBatch) {
+    FlatHashMap<int> table(4);
+    table.get_or_insert(0, 10);
+    table.get_or_insert(std::numeric_limits<ull>::max(), 20);
+
+    ull keys[] = {0, 1, std::numeric_limits<ull>::max()};
+    const int* values[3];
+    table.find_batch(keys, 3, values);
+    ASSERT_EQ(*values[0], 10);
+    ASSERT_EQ(values[1], nullptr);
+    ASSERT_EQ(*values[2], 20);
+}
@@ -1,5 +1,9 @@
 #pragma once
+#include <map>
+
 #include "../src/lib/hashing.hpp"
+#include "../src/lib/eval_composable.hpp"
+#include "test_utils.hpp"
 
 #include "gtest/gtest.h"
 
@@ -66,3 +70,209 @@ TEST(GridHashing, BucketSphereIntersect) {
     ASSERT_FALSE(gh.bucket_sphere_intersect(p3, sqrt(2.0) * cs_half - epsilon, bucket));
     ASSERT_TRUE(gh.bucket_sphere_intersect(p3, sqrt(2.0) * cs_half + epsilon, bucket));
 }
+
+TEST(GridHashing, BatchMatchesEvalBall) {
+    seed(7);
+    int dim = 3;
+    double radius = 0.5;
+    std::vector<tagged_point> points(3000, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 10) * scale;
+    }
+
+    GridHashing<int> gh(dim, radius);
+    std::vector<ull> hashes(points.size()), cells(points.size() * dim);
+    std::map<ull, std::vector<int>> batches;
+    for (size_t i=0; i<points.size(); i++) {
+        hashes[i] = gh.hash(points[i], &cells[i * dim]);
+        batches[hashes[i]].push_back(i);
+    }
+
+    for (bool exact: {false, true}) {
+        BucketTable<int> bucket_values = exact ? BucketTable<int>(dim, cells) : BucketTable<int>(points.size());
+        for (size_t i=0; i<points.size(); i++) {
+            bucket_values.get_or_insert(hashes[i], &cells[i * dim], 0)++;
+        }
+
+        std::vector<int> results(points.size(), -1);
+        for (auto& [_, batch]: batches) {
+            std::vector<const tagged_point*> centers;
+            for (int i: batch) centers.push_back(&points[i]);
+            std::vector<int> batch_results(batch.size());
+            gh.eval_ball_batch(centers.data(), batch.size(), radius, Composable::Size, bucket_values, batch_results.data());
+            for (size_t j=0; j<batch.size(); j++) results[batch[j]] = batch_results[j];
+        }
+        for (size_t i=0; i<points.size(); i++) {
+            ASSERT_EQ(results[i], gh.eval_ball(points[i], radius, Composable::Size, bucket_values));
+        }
+    }
+}
+
+TEST(CellHash, PolynomialMatchesModulo) {
+    int dim = 4;
+    CellHash h(dim, PolynomialCellHash);
+    ull p = h.hash_mod();
+
+    for (int t=0; t<1000; t++) {
+        std::vector<ull> cell(dim);
+        for (ull& c: cell) {
+            c = randRange<ull>(0, std::numeric_limits<ull>::max());
+        }
+        ull expected = 0;
+        for (int i=0; i<dim; i++) {
+            expected = (expected * h.hash_poly() % p + cell[i] % p) % p;
+        }
+        ASSERT_EQ(h([&](int i) { return cell[i]; }), expected);
+    }
+}
+
+TEST(CellHash, KeyedDistinctCells) {
+    int dim = 3;
+    CellHash h(dim, KeyedCellHash);
+
+    // Cells that collide under any polynomial hash modulo 2^31-1
+    std::vector<ull> c1 = {1, 2, 3};
+    std::vector<ull> c2 = {1, 2, 3 + CellHash::hash_mod()};
+    ASSERT_NE(h([&](int i) { return c1[i]; }), h([&](int i) { return c2[i]; }));
+
+    std::unordered_set<ull> hashes;
+    for (ull x=0; x<100; x++) {
+        for (ull y=0; y<100; y++) {
+            for (ull z=0; z<100; z++) {
+                std::vector<ull> c = {x, y, z};
+                hashes.insert(h([&](int i) { return c[i]; }));
+            }
+        }
+    }
+    ASSERT_EQ(hashes.size(), 1000000);
+}
+
+TEST(LSHHashing, SeparatesClusters) {
+    seed(3);
+    int dim = 50;
+    std::vector<tagged_point> points;
+    for (int c=0; c<2; c++) {
+        for (int i=0; i<100; i++) {
+            points.emplace_back(dim);
+            for (int d=0; d<dim; d++) {
+                points.back()[d] = (100.0 * c + randDouble(0, 0.01)) * scale;
+            }
+        }
+    }
+
+    for (BucketIdentity identity: {HashBucketIdentity, CellBucketIdentity}) {
+        bucket_identity_guard guard(identity);
+        auto sizes = eval_composable(dim, points, 1.0, Composable::Size, LSHHashingScheme);
+        for (int size: sizes) {
+            ASSERT_EQ(size, 100);
+        }
+    }
+}
+
+TEST(LSHHashing, BallsContainNeighbors) {
+    seed(41);
+    int dim = 50, n = 400;
+    double radius = 1.0;
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (int i=0; i<n; i++) {
+        // Clusters of 10 points, pairs within a cluster are at distance about 0.8
+        for (int d=0; d<dim; d++) {
+            points[i][d] = ((i / 10) * 10.0 + randDouble(0, 0.2)) * scale;
+        }
+    }
+
+    LSHHashing<int> lsh(dim, radius, 16, 4);
+    std::vector<ull> cell(lsh.cell_dimension());
+    int neighbor_pairs = 0;
+    for (const tagged_point& p: points) {
+        // One bucket of value 1 for every bucket holding a point of B_P(p, r), all of them are in A_P(p, r)
+        BucketTable<int> neighbor_buckets;
+        for (const tagged_point& q: points) {
+            if (p.dist(q) > radius) continue;
+            neighbor_buckets.get_or_insert(lsh.hash(q, cell.data()), cell.data(), 1);
+            neighbor_pairs++;
+        }
+        ASSERT_EQ(lsh.eval_ball(p, radius, Composable::Size, neighbor_buckets), (int) neighbor_buckets.size());
+    }
+    ASSERT_GT(neighbor_pairs, 2 * n);
+}
+
+TEST(LSHHashing, ConsistentCells) {
+    int dim = 10;
+    LSHHashing<int> lsh(dim, 1.0, 8, 3);
+    ASSERT_EQ(lsh.cell_dimension(), 4);
+
+    point p(dim);
+    for (int d=0; d<dim; d++) p[d] = randDouble(-5, 5) * scale;
+    std::vector<ull> cell(lsh.cell_dimension());
+    ASSERT_EQ(lsh.hash(p), lsh.hash(p, cell.data()));
+    ASSERT_LE(cell[0], 8);
+}
+
+TEST(LatticeHashing, EvenCells) {
+    int dim = 6;
+    LatticeHashing<int> lattice(dim, 1.0);
+    std::vector<ull> cell(dim);
+    for (int i=0; i<1000; i++) {
+        point p(dim);
+        for (int d=0; d<dim; d++) p[d] = randDouble(-5, 5) * scale;
+        ASSERT_EQ(lattice.hash(p), lattice.hash(p, cell.data()));
+        ull sum = 0;
+        for (int d=0; d<dim; d++) sum += cell[d];
+        ASSERT_EQ(sum % 2, 0);
+    }
+}
+
+TEST(LatticeHashing, ApproximatesBalls) {
+    seed(5);
+    double radius = 1.0;
+    for (int dim: {2, 4, 7}) {
+        LatticeHashing<int> lattice(dim, radius);
+        double extent = lattice.ball_extent(radius);
+        std::vector<ull> center_cell(dim), cell(dim);
+        for (int trial=0; trial<2000; trial++) {
+            tagged_point center(dim), p(dim);
+            std::vector<double> direction(dim);
+            double norm = 0;
+            for (int d=0; d<dim; d++) {
+                center[d] = randDouble(0, 100) * scale;
+                direction[d] = randNormal(0.0, 1.0);
+                norm += direction[d] * direction[d];
+            }
+            // Half of the points on the sphere of radius r, the others up to twice the extent away
+            double dist = trial % 2 ? radius : randDouble(0, 2 * extent);
+            for (int d=0; d<dim; d++) {
+                p[d] = center[d] + (ll) (direction[d] / sqrt(norm) * dist * scale);
+            }
+
+            // A table with only the bucket of p, which the ball finds if and only if it returns the bucket
+            ull hash = lattice.hash(p, cell.data());
+            BucketTable<int> table(dim, cell);
+            table.get_or_insert(hash, cell.data(), 1);
+            int found = lattice.eval_ball(center, radius, Composable::Size, table);
+            if (center.dist(p) <= radius) ASSERT_EQ(found, 1) << "dim " << dim << " trial " << trial;
+            if (found) ASSERT_LE(center.dist(p), extent) << "dim " << dim << " trial " << trial;
+        }
+    }
+}
+
+TEST(HashingScheme, BallExtentBoundsBalls) {
+    seed(9);
+    int dim = 3;
+    double radius = 0.5;
+    std::vector<tagged_point> points(1000, tagged_point(dim));
+    for (auto& p: points) {
+        for (int d=0; d<dim; d++) p[d] = randDouble(0, 5) * scale;
+    }
+
+    for (HashingSchemeChoice hs_choice: {GridHashingScheme, FaceHashingScheme, LatticeHashingScheme}) {
+        double extent = make_hashing_scheme<int>(hs_choice, dim, radius)->ball_extent(radius);
+        ASSERT_LT(extent, std::numeric_limits<double>::infinity());
+        auto sizes = eval_composable(dim, points, radius, Composable::Size, hs_choice);
+        for (size_t i=0; i<points.size(); i++) {
+            int extent_count = 0;
+            for (auto& q: points) extent_count += points[i].dist(q) <= extent;
+            ASSERT_LE(sizes[i], extent_count);
+        }
+    }
+}
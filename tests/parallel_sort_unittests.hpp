@@ -0,0 +1,20 @@
+#pragma once
+#include "../src/lib/parallel_sort.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(ParallelSort, MatchesSequentialSort) {
+    int max_threads = omp_get_max_threads();
+    for (int threads: {1, 3, 4}) {
+        omp_set_num_threads(threads);
+        std::vector<int> values(100000 + threads);
+        for (int& v: values) v = randRange(-1000, 1000);
+        std::vector<int> expected(values);
+        std::sort(expected.begin(), expected.end());
+
+        parallel_sort(values);
+        EXPECT_EQ(values, expected);
+    }
+    omp_set_num_threads(max_threads);
+}
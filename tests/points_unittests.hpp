@@ -1,5 +1,10 @@
 #pragma once
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
 #include "../src/lib/points.hpp"
+#include "../src/lib/random.hpp"
 
 #include "gtest/gtest.h"
 
@@ -22,4 +27,151 @@ TEST(Points, Distance) {
     ASSERT_EQ(origin.dist_squared(p2), 1.0);
     ASSERT_EQ(origin.dist_squared(p3), 2.0);
     ASSERT_EQ(p1.dist(p2), sqrt(2.0));
+    ASSERT_EQ(origin.dist_squared_scaled(p3), 2.0 * scale * scale);
+}
+
+TEST(Points, SolutionCost) {
+    int dim = 3;
+    std::vector<tagged_point> points;
+    for (int i=0; i<500; i++) {
+        point p({randDouble(-5, 5), randDouble(-5, 5), randDouble(-5, 5)});
+        points.emplace_back(dim);
+        points.back().coords = p.coords;
+    }
+    std::vector<point> facilities(points.begin(), points.begin() + 7);
+
+    double expected = 7 * 2.5;
+    for (const auto& p: points) {
+        expected += pow(min_dist(p, facilities).dist, 1.5);
+    }
+    ASSERT_NEAR(solution_cost(points, facilities, 2.5, pow_z_real{1.5}), expected, 1e-9 * expected);
+}
+
+TEST(Points, WeightedSolutionCost) {
+    int dim = 2;
+    std::vector<weighted_point> points;
+    std::vector<tagged_point> duplicated;
+    for (int i=0; i<200; i++) {
+        point p({randDouble(-5, 5), randDouble(-5, 5)});
+        points.emplace_back(dim);
+        points.back().coords = p.coords;
+        points.back().weight = randRange(0, 4);
+        for (int w=0; w<points.back().weight; w++) {
+            duplicated.push_back(points.back());
+        }
+    }
+    std::vector<int> facility_indexes = {3, 50, 120};
+    std::vector<point> facilities;
+    for (int i: facility_indexes) facilities.push_back(points[i]);
+
+    double expected = solution_cost(duplicated, facilities, 1.5, pow_z<2>());
+    ASSERT_NEAR(solution_cost(points, facilities, 1.5, pow_z<2>()), expected, 1e-9 * expected);
+    ASSERT_NEAR(solution_cost(points, facility_indexes, 1.5, pow_z<2>()), expected, 1e-9 * expected);
+}
+
+TEST(Points, NearestNeighbors) {
+    std::vector<tagged_point> points;
+    for (double x: {0.0, 3.0, 7.5, 8.0, 12.0}) {
+        tagged_point p(2);
+        p[0] = x * scale;
+        p[1] = 2 * x * scale;
+        points.push_back(p);
+    }
+    double closest = sqrt(0.5*0.5 + 1.0*1.0);
+    double estimate = nearest_neighbors(2, points, 64);
+    ASSERT_LE(estimate, closest + 1e-9);
+    ASSERT_GT(estimate, 0.5 * closest);
+}
+
+TEST(Points, AspectRatio) {
+    int dim = 3;
+    std::vector<tagged_point> points(700, tagged_point(dim));
+    for (auto& p: points) {
+        for (int i=0; i<dim; i++) p[i] = randRange<ll>(0, 1e17);
+    }
+    points[5] = points[17]; // duplicates are ignored for the minimum
+
+    double min_d = std::numeric_limits<double>::infinity(), max_d = 0;
+    for (size_t i=0; i<points.size(); i++) {
+        for (size_t j=i+1; j<points.size(); j++) {
+            double d = points[i].dist(points[j]);
+            max_d = std::max(max_d, d);
+            if (d != 0) min_d = std::min(min_d, d);
+        }
+    }
+
+    auto [min_ar, max_ar] = aspect_ratio(dim, points);
+    ASSERT_DOUBLE_EQ(min_ar, min_d);
+    ASSERT_DOUBLE_EQ(max_ar, max_d);
+}
+
+TEST(Points, ClosestPair) {
+    for (int dim: {2, 4}) {
+        std::vector<tagged_point> points(5000, tagged_point(dim));
+        for (auto& p: points) {
+            for (int i=0; i<dim; i++) p[i] = randRange<ll>(-1e17, 1e17);
+        }
+        points[10] = points[20];
+        ASSERT_DOUBLE_EQ(closest_pair(dim, points), aspect_ratio(dim, points).first);
+    }
+}
+
+TEST(Points, ChunkedPointReader) {
+    std::stringstream in("5 2 1\n0 0\n1 1\n2 2\n3 3\n4 4\n");
+    int n, dim; double cost;
+    in >> n >> dim >> cost;
+    ChunkedPointReader reader(in, n, dim, 2);
+
+    std::vector<tagged_point> chunk;
+    for (int pass=0; pass<2; pass++) {
+        reader.rewind();
+        std::vector<size_t> sizes;
+        while (reader.next(chunk)) {
+            size_t offset = reader.position() - chunk.size();
+            for (size_t i=0; i<chunk.size(); i++) {
+                ASSERT_EQ(chunk[i][0], (ll) (offset + i) * scale);
+            }
+            sizes.push_back(chunk.size());
+        }
+        ASSERT_EQ(sizes, std::vector<size_t>({2, 2, 1}));
+    }
+}
+
+TEST(Points, ChunkedSolutionCost) {
+    seed(7);
+    int n = 50, dim = 3;
+    std::stringstream in;
+    in << std::setprecision(17);
+    for (int i=0; i<n; i++) {
+        for (int d=0; d<dim; d++) {
+            in << randDouble(0, 10) << (d+1 < dim ? " " : "\n");
+        }
+    }
+    std::vector<tagged_point> points = load_points(n, dim, in);
+
+    std::vector<int> facility_indexes = {31, 4, 17, 49};
+    for (size_t chunk_size: {1, 7, 100}) {
+        in.clear();
+        in.seekg(0);
+        ChunkedPointReader reader(in, n, dim, chunk_size);
+        std::vector<tagged_point> read = read_points(reader, facility_indexes);
+        ASSERT_EQ(read.size(), facility_indexes.size());
+        std::vector<point> facilities;
+        for (size_t i=0; i<read.size(); i++) {
+            ASSERT_EQ(read[i], points[facility_indexes[i]]);
+            facilities.push_back(read[i]);
+        }
+        ASSERT_DOUBLE_EQ(solution_cost(reader, facilities, 2.5, pow_z<2>()), solution_cost(points, facility_indexes, 2.5, pow_z<2>()));
+    }
+}
+
+TEST(Points, TruncatedInput) {
+    std::stringstream in("0 0\n1 1\n2");
+    ASSERT_THROW(load_points(3, 2, in), std::runtime_error);
+
+    std::stringstream chunked("0 0\n1 1\n2 2\n3");
+    ChunkedPointReader reader(chunked, 4, 2, 2);
+    std::vector<tagged_point> chunk;
+    ASSERT_TRUE(reader.next(chunk));
+    ASSERT_THROW(reader.next(chunk), std::runtime_error);
 }
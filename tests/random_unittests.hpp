@@ -0,0 +1,50 @@
+#pragma once
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+#include <omp.h>
+
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+/// The first draw of each of `threads` threads of a parallel region.
+static std::vector<ull> first_draws(int threads) {
+    std::vector<ull> draws(threads);
+    #pragma omp parallel num_threads(threads)
+    {
+        draws[omp_get_thread_num()] = randRange(0ULL, std::numeric_limits<ull>::max());
+    }
+    return draws;
+}
+
+TEST(Random, ThreadsDeriveFromSeed) {
+    int threads = 4;
+    seed(1);
+    std::vector<ull> draws = first_draws(threads);
+    ASSERT_EQ(std::set<ull>(draws.begin(), draws.end()).size(), threads);
+
+    seed(1);
+    ASSERT_EQ(first_draws(threads), draws);
+    seed(2);
+    std::vector<ull> other = first_draws(threads);
+    for (int t=0; t<threads; t++) {
+        ASSERT_NE(other[t], draws[t]);
+    }
+
+    // Thread 0 draws as a generator seeded by the seed itself
+    std::mt19937 expected(2);
+    seed(2);
+    ASSERT_EQ(randRange(0ULL, std::numeric_limits<ull>::max()), std::uniform_int_distribution<ull>()(expected));
+}
+
+TEST(Random, SeedGuardRestoresThread) {
+    seed(3);
+    std::mt19937 before = rng(), expected(5);
+    {
+        thread_seed_guard guard(5);
+        ASSERT_EQ(randRange(0, 1000), std::uniform_int_distribution<int>(0, 1000)(expected));
+    }
+    ASSERT_TRUE(rng() == before);
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <signal.h>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/lib/points.hpp"
+#include "../src/lib/random.hpp"
+#include "test_utils.hpp"
+
+#include "gtest/gtest.h"
+
+/// Runs `build/server` on a socket in a temporary directory (tests run from the root of the repository).
+class server_process {
+  private:
+    std::string _directory;
+    pid_t _pid;
+
+  public:
+    server_process() {
+        char directory[] = "/tmp/server_unittest_XXXXXX";
+        _directory = mkdtemp(directory);
+        _pid = fork();
+        if (_pid == 0) {
+            execl("build/server", "server", path("socket").c_str(), (char*) NULL);
+            _exit(127);
+        }
+    }
+
+    ~server_process() {
+        kill(_pid, SIGTERM);
+        waitpid(_pid, NULL, 0);
+        unlink(path("socket").c_str());
+        unlink(path("points.in").c_str());
+        rmdir(_directory.c_str());
+    }
+
+    /// A file in the temporary directory, removed with it if named `points.in`.
+    std::string path(const std::string& name) const {
+        return _directory + "/" + name;
+    }
+
+    /// Sends a request on a new connection, waiting for the server to start, and gives the response line.
+    std::string request(const std::string& line) const {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        path("socket").copy(address.sun_path, sizeof(address.sun_path) - 1);
+        for (int attempt=0; attempt<100; attempt++) {
+            int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (connect(connection, (sockaddr*) &address, sizeof(address)) != 0) {
+                close(connection);
+                usleep(50000);
+                continue;
+            }
+            std::string message = line + "\n";
+            send(connection, message.data(), message.size(), MSG_NOSIGNAL);
+            shutdown(connection, SHUT_WR);
+            std::string response;
+            char chunk[4096];
+            ssize_t received;
+            while ((received = recv(connection, chunk, sizeof(chunk), 0)) > 0) {
+                response.append(chunk, received);
+            }
+            close(connection);
+            if (!response.empty() && response.back() == '\n') response.pop_back();
+            return response;
+        }
+        return "no server";
+    }
+};
+
+/// One k of a `sweep` response.
+struct swept_solution {
+    int k;
+    std::string cost;
+    std::vector<int> centers;
+};
+
+/// Parses `ok <time> <k> <cost> <count> <indexes...> ; <k> ...`.
+static std::vector<swept_solution> parse_sweep(const std::string& response) {
+    std::istringstream in(response);
+    std::string ok, separator;
+    double time;
+    in >> ok >> time;
+    std::vector<swept_solution> solutions;
+    do {
+        swept_solution solution;
+        size_t count;
+        in >> solution.k >> solution.cost >> count;
+        solution.centers.resize(count);
+        for (int& c: solution.centers) in >> c;
+        solutions.push_back(solution);
+    } while (in >> separator && separator == ";");
+    return solutions;
+}
+
+TEST(Server, SweepOverSocket) {
+    seed(59);
+    int dim = 2, clusters = 8, n = 800;
+    std::vector<tagged_point> points = clustered_points(dim, n, clusters);
+    server_process server;
+    {
+        std::ofstream file(server.path("points.in"));
+        file << n << " " << dim << " " << 1 << "\n" << std::setprecision(17);
+        for (const tagged_point& p: points) {
+            file << (double) p[0] / scale << " " << (double) p[1] / scale << "\n";
+        }
+    }
+    ASSERT_EQ(server.request("load points " + server.path("points.in")), "ok 800 2");
+
+    std::string response = server.request("sweep points 8,1,4,2 grid_hashing 1f");
+    ASSERT_EQ(response.substr(0, 3), "ok ");
+    std::vector<swept_solution> solutions = parse_sweep(response);
+    std::vector<int> ks = {8, 1, 4, 2};
+    ASSERT_EQ(solutions.size(), ks.size());
+    std::map<int, double> costs;
+    for (size_t i=0; i<ks.size(); i++) {
+        ASSERT_EQ(solutions[i].k, ks[i]);
+        ASSERT_FALSE(solutions[i].centers.empty());
+        ASSERT_LT(solutions[i].centers.size(), 1.1 * ks[i]);
+        for (int c: solutions[i].centers) {
+            ASSERT_GE(c, 0);
+            ASSERT_LT(c, n);
+        }
+        costs[ks[i]] = std::stod(solutions[i].cost);
+    }
+    for (auto it = std::next(costs.begin()); it != costs.end(); it++) {
+        ASSERT_LT(it->second, std::prev(it)->second);
+    }
+
+    // A sweep of a single k solves it as `solve` does with the same seed
+    std::vector<swept_solution> single = parse_sweep(server.request("sweep points 4 grid_hashing 2f"));
+    std::istringstream solved(server.request("solve points clustering 4 grid_hashing 2f"));
+    std::string ok, cost;
+    double time;
+    size_t count;
+    solved >> ok >> cost >> time >> count;
+    std::vector<int> centers(count);
+    for (int& c: centers) solved >> c;
+    ASSERT_EQ(ok, "ok");
+    ASSERT_EQ(single.size(), 1);
+    ASSERT_EQ(single[0].cost, cost);
+    ASSERT_EQ(single[0].centers, centers);
+
+    // Invalid requests are answered without stopping the server
+    ASSERT_EQ(server.request("sweep points 0 grid_hashing 1f").substr(0, 6), "error ");
+    ASSERT_EQ(server.request("sweep points 4,801 grid_hashing 1f").substr(0, 6), "error ");
+    for (std::string request: {
+        "sweep points 4x grid_hashing 1f",
+        "sweep points 4 grid_hashing 1f abc",
+        "sweep points 4 grid_hashing 1f 2 3",
+        "solve points clustering 4 grid_hashing 1f 0.5",
+        "solve points clustering 4 grid_hashing 1f 2x",
+        "solve points clustering 1e300 grid_hashing 1f",
+        "solve points clustering nan grid_hashing 1f",
+        "solve points clustering 2.5 grid_hashing 1f",
+        "solve points facility_set inf grid_hashing 1f",
+        "solve points facility_set 1 grid_hashing 1f nan",
+    }) {
+        ASSERT_EQ(server.request(request).substr(0, 6), "error ") << request;
+    }
+    ASSERT_EQ(server.request("solve points clustering 4 grid_hashing 1f 2").substr(0, 3), "ok ");
+    ASSERT_EQ(server.request("shutdown"), "ok");
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cmath>
+#include <vector>
+
+#include "../src/lib/hashing.hpp"
+#include "../src/lib/points.hpp"
+#include "../src/lib/random.hpp"
+
+#include "gtest/gtest.h"
+
+/// Sets the global `bucket_identity` for the lifetime of the guard, restoring the previous one even if a test fails.
+class bucket_identity_guard {
+  private:
+    BucketIdentity _previous;
+
+  public:
+    bucket_identity_guard(BucketIdentity identity) : _previous(bucket_identity) {
+        bucket_identity = identity;
+    }
+    ~bucket_identity_guard() { bucket_identity = _previous; }
+};
+
+/// Distance between the clusters of `clustered_points` along the first axis.
+constexpr double cluster_distance = 10.0;
+
+/**
+ * @brief Points in `clusters` cubes of side 0.1, `cluster_distance` apart along the first axis.
+ * @return `n` points, the i-th of which is in cluster i % `clusters`.
+ */
+inline std::vector<tagged_point> clustered_points(int dim, int n, int clusters) {
+    std::vector<tagged_point> points(n, tagged_point(dim));
+    for (int i=0; i<n; i++) {
+        points[i][0] = ((i % clusters) * cluster_distance + randDouble(0, 0.1)) * scale;
+        for (int d=1; d<dim; d++) {
+            points[i][d] = randDouble(0, 0.1) * scale;
+        }
+    }
+    return points;
+}
+
+/// The cluster of a point of `clustered_points`.
+inline int cluster_of(const point& p) {
+    return (int) round((double) p[0] / scale / cluster_distance);
+}
+
+/// Whether the chosen indexes are points of `clustered_points` with one in every cluster.
+template<IsPoint T>
+testing::AssertionResult opens_every_cluster(const std::vector<T>& points, const std::vector<int>& chosen, int clusters) {
+    std::vector<bool> opened(clusters, false);
+    for (int c: chosen) {
+        if (c < 0 || c >= (int) points.size()) return testing::AssertionFailure() << "index " << c << " out of range";
+        opened[cluster_of(points[c])] = true;
+    }
+    for (int c=0; c<clusters; c++) {
+        if (!opened[c]) return testing::AssertionFailure() << "cluster " << c << " not opened";
+    }
+    return testing::AssertionSuccess();
+}
@@ -1,6 +1,17 @@
 #include "bin_search_unittests.hpp"
+#include "bucket_cache_unittests.hpp"
+#include "bucket_table_unittests.hpp"
+#include "clustering_unittests.hpp"
+#include "compact_points_unittests.hpp"
+#include "dimension_reduction_unittests.hpp"
+#include "duplicates_unittests.hpp"
+#include "facility_set_unittests.hpp"
+#include "flat_hash_map_unittests.hpp"
 #include "hashing_unittests.hpp"
+#include "parallel_sort_unittests.hpp"
 #include "points_unittests.hpp"
+#include "random_unittests.hpp"
+#include "server_unittests.hpp"
 
 #include "gtest/gtest.h"
 